@@ -0,0 +1,323 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "PerfCounters.h"
+
+namespace benchmark {
+
+/**
+ *  @brief Make the compiler assume "value" is read, so the computation of it is not deleted.
+*/
+template<typename T>
+inline void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ *  @brief Make the compiler assume "value" is read and modified, so it is neither deleted nor folded.
+*/
+template<typename T>
+inline void DoNotOptimize(T& value) {
+    asm volatile("" : "+r,m"(value) : : "memory");
+}
+
+/**
+ *  @brief Make the compiler assume all memory is read and written, pending stores are not deleted.
+*/
+inline void ClobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+/**
+ *  @brief Options of Runner.
+ *  warmup_runs - untimed runs before the measured ones, they also calibrate the batch size.
+ *  runs - measured runs, statistics are taken over them.
+ *  min_run_time - a run repeats the function until it takes at least this many seconds.
+ *  filter - only benchmarks whose name contains it are run, empty runs all.
+ *  json_path - write the results as JSON to this file, "-" writes to stdout, empty writes nothing.
+ *  counters - count hardware events over the measured runs, ignored when perf_event_open is not available.
+ *  large - also run the benchmarks on the largest inputs, they need several GB of memory.
+*/
+struct Options {
+    std::size_t warmup_runs = 2;
+    std::size_t runs = 15;
+    double min_run_time = 0.05;
+    std::string filter;
+    std::string json_path;
+    bool counters = true;
+    bool large = false;
+};
+
+/**
+ *  @brief Statistics of one benchmark, times are nanoseconds per operation.
+*/
+struct Result {
+    std::string name;
+    std::size_t runs = 0;
+    std::size_t batch = 0;
+    std::uint64_t ops_per_call = 0;
+    double min_ns = 0;
+    double p10_ns = 0;
+    double median_ns = 0;
+    double p90_ns = 0;
+    double max_ns = 0;
+    double mean_ns = 0;
+    double stddev_ns = 0;
+    PerfCounters::Values counters_per_op;
+
+    /**
+     *  @brief Returns operations per second at the median time.
+    */
+    inline double OpsPerSecond() const {
+        return median_ns == 0 ? 0.0 : 1e9 / median_ns;
+    }
+
+    /**
+     *  @brief Returns instructions per cycle, 0 when either counter is not available.
+    */
+    inline double InstructionsPerCycle() const {
+        const PerfCounters::Values& c = counters_per_op;
+        if (!c.available[PerfCounters::Cycles] || !c.available[PerfCounters::Instructions]
+            || c.counts[PerfCounters::Cycles] == 0) {
+            return 0.0;
+        }
+        return c.counts[PerfCounters::Instructions] / c.counts[PerfCounters::Cycles];
+    }
+};
+
+/**
+ *  @brief Runs benchmarks with warm-up and repetition and reports robust statistics
+ *  Each benchmark is a function doing "ops_per_call" operations per call. A run calls it "batch" times in a
+ *  row, the batch is sized in the warm-up so that a run takes at least "min_run_time". The result of a
+ *  function that returns a value is passed to DoNotOptimize. Hardware counters, when enabled and available, are
+ *  counted over the measured runs only and reported per operation.
+*/
+class Runner {
+    Options options_;
+    std::vector<Result> results_;
+    std::unique_ptr<PerfCounters> counters_;
+
+    using clock = std::chrono::steady_clock;
+
+    template<typename Func>
+    static inline double TimeBatch(Func& func, std::size_t batch) {
+        const auto start = clock::now();
+        for (std::size_t i = 0; i < batch; ++i) {
+            if constexpr (std::is_void_v<decltype(func())>) {
+                func();
+            } else {
+                auto result = func();
+                DoNotOptimize(result);
+            }
+            ClobberMemory();
+        }
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    }
+
+    static inline double Percentile(const std::vector<double>& sorted, double p) {
+        const double position = p * static_cast<double>(sorted.size() - 1);
+        const std::size_t lower = static_cast<std::size_t>(position);
+        const std::size_t upper = std::min(lower + 1, sorted.size() - 1);
+        return sorted[lower] + (sorted[upper] - sorted[lower]) * (position - static_cast<double>(lower));
+    }
+
+    static void PrintJsonString(std::ostream& out, const std::string& value) {
+        out << '"';
+        for (char c : value) {
+            if (c == '"' || c == '\\') out << '\\';
+            out << c;
+        }
+        out << '"';
+    }
+
+public:
+    explicit Runner(Options options = {}) : options_(std::move(options)) {
+        if (options_.counters) {
+            counters_ = std::make_unique<PerfCounters>();
+            if (!counters_->IsAvailable()) {
+                Log() << "Hardware counters are not available (perf_event_open failed), reporting time only"
+                      << std::endl;
+                counters_.reset();
+            }
+        }
+    }
+
+    /**
+     *  @brief Parse "--runs N --warmup N --min-time SECONDS --filter TEXT --json PATH --counters 0|1
+     *  --large 0|1"
+     *  from the command line.
+     *  Prints usage and exits on "--help" or an unknown argument.
+    */
+    static Options ParseOptions(int argc, char** argv) {
+        Options options;
+        auto usage = [argv](int code) {
+            std::cout << "Usage: " << argv[0]
+                      << " [--runs N] [--warmup N] [--min-time SECONDS] [--filter TEXT] [--json PATH|-]"
+                      << " [--counters 0|1] [--large 0|1]" << std::endl;
+            std::exit(code);
+        };
+        for (int i = 1; i < argc; ++i) {
+            const char* arg = argv[i];
+            if (std::strcmp(arg, "--help") == 0) usage(0);
+            if (i + 1 >= argc) usage(1);
+            const char* value = argv[++i];
+            if (std::strcmp(arg, "--runs") == 0) {
+                options.runs = std::max<std::size_t>(1, std::strtoull(value, nullptr, 10));
+            } else if (std::strcmp(arg, "--warmup") == 0) {
+                options.warmup_runs = std::strtoull(value, nullptr, 10);
+            } else if (std::strcmp(arg, "--min-time") == 0) {
+                options.min_run_time = std::strtod(value, nullptr);
+            } else if (std::strcmp(arg, "--filter") == 0) {
+                options.filter = value;
+            } else if (std::strcmp(arg, "--json") == 0) {
+                options.json_path = value;
+            } else if (std::strcmp(arg, "--counters") == 0) {
+                options.counters = std::strcmp(value, "0") != 0;
+            } else if (std::strcmp(arg, "--large") == 0) {
+                options.large = std::strcmp(value, "0") != 0;
+            } else {
+                usage(1);
+            }
+        }
+        return options;
+    }
+
+    inline const Options& GetOptions() const {
+        return options_;
+    }
+
+    /**
+     *  @brief Returns the stream of human-readable output, std::cerr when the JSON goes to stdout.
+    */
+    inline std::ostream& Log() const {
+        return options_.json_path == "-" ? std::cerr : std::cout;
+    }
+
+    /**
+     *  @brief Run "func" and record its statistics under "name", one line of them is printed.
+     *  @param ops_per_call Count of operations done by one call, times are reported per operation.
+    */
+    template<typename Func>
+    void Run(const std::string& name, std::uint64_t ops_per_call, Func&& func) {
+        if (!options_.filter.empty() && name.find(options_.filter) == std::string::npos) return;
+
+        // Warm-up, then grow the batch until a run is long enough to be timed reliably
+        std::size_t batch = 1;
+        for (std::size_t i = 0; i < options_.warmup_runs; ++i) {
+            TimeBatch(func, batch);
+        }
+        const double min_run_ns = options_.min_run_time * 1e9;
+        while (true) {
+            const double elapsed = TimeBatch(func, batch);
+            if (elapsed >= min_run_ns || batch >= (std::size_t(1) << 30)) break;
+            const double scale = elapsed <= 0 ? 10.0 : std::min(10.0, 1.2 * min_run_ns / elapsed);
+            batch = std::max(batch + 1, static_cast<std::size_t>(static_cast<double>(batch) * scale));
+        }
+
+        std::vector<double> samples;
+        samples.reserve(options_.runs);
+        const double ops_per_run = static_cast<double>(batch) * static_cast<double>(std::max<std::uint64_t>(1, ops_per_call));
+        if (counters_) counters_->Reset();
+        for (std::size_t i = 0; i < options_.runs; ++i) {
+            if (counters_) counters_->Enable();
+            const double elapsed = TimeBatch(func, batch);
+            if (counters_) counters_->Disable();
+            samples.push_back(elapsed / ops_per_run);
+        }
+        std::sort(samples.begin(), samples.end());
+
+        Result result;
+        result.name = name;
+        result.runs = samples.size();
+        result.batch = batch;
+        result.ops_per_call = ops_per_call;
+        result.min_ns = samples.front();
+        result.p10_ns = Percentile(samples, 0.1);
+        result.median_ns = Percentile(samples, 0.5);
+        result.p90_ns = Percentile(samples, 0.9);
+        result.max_ns = samples.back();
+        double sum = 0;
+        for (double sample : samples) sum += sample;
+        result.mean_ns = sum / static_cast<double>(samples.size());
+        double squares = 0;
+        for (double sample : samples) squares += (sample - result.mean_ns) * (sample - result.mean_ns);
+        result.stddev_ns = samples.size() < 2 ? 0.0 : std::sqrt(squares / static_cast<double>(samples.size() - 1));
+        if (counters_) {
+            result.counters_per_op = counters_->Read();
+            for (double& count : result.counters_per_op.counts) {
+                count /= ops_per_run * static_cast<double>(options_.runs);
+            }
+        }
+
+        std::ostream& log = Log();
+        log << result.name << ": " << result.median_ns << " ns/op, " << result.OpsPerSecond() << " ops/s"
+            << " (p10=" << result.p10_ns << " p90=" << result.p90_ns << " stddev=" << result.stddev_ns
+            << ", " << result.runs << " runs x " << result.batch << ")" << std::endl;
+        if (counters_) {
+            log << "    per op:";
+            for (std::size_t event = 0; event < PerfCounters::event_count; ++event) {
+                if (result.counters_per_op.available[event]) {
+                    log << " " << PerfCounters::GetName(event) << "=" << result.counters_per_op.counts[event];
+                }
+            }
+            if (result.InstructionsPerCycle() != 0) {
+                log << " IPC=" << result.InstructionsPerCycle();
+            }
+            log << std::endl;
+        }
+        results_.push_back(std::move(result));
+    }
+
+    inline const std::vector<Result>& Results() const {
+        return results_;
+    }
+
+    /**
+     *  @brief Write all results as a JSON object with a "benchmarks" array.
+    */
+    void PrintJson(std::ostream& out) const {
+        out << "{\n  \"benchmarks\": [";
+        for (std::size_t i = 0; i < results_.size(); ++i) {
+            const Result& result = results_[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+            PrintJsonString(out, result.name);
+            out << ", \"runs\": " << result.runs << ", \"batch\": " << result.batch
+                << ", \"ops_per_call\": " << result.ops_per_call
+                << ", \"ns_per_op\": " << result.median_ns << ", \"ops_per_second\": " << result.OpsPerSecond()
+                << ", \"min_ns\": " << result.min_ns << ", \"p10_ns\": " << result.p10_ns
+                << ", \"median_ns\": " << result.median_ns << ", \"p90_ns\": " << result.p90_ns
+                << ", \"max_ns\": " << result.max_ns << ", \"mean_ns\": " << result.mean_ns
+                << ", \"stddev_ns\": " << result.stddev_ns;
+            if (counters_) {
+                out << ", \"counters_per_op\": {";
+                const char* separator = "";
+                for (std::size_t event = 0; event < PerfCounters::event_count; ++event) {
+                    if (result.counters_per_op.available[event]) {
+                        out << separator << '"' << PerfCounters::GetName(event) << "\": "
+                            << result.counters_per_op.counts[event];
+                        separator = ", ";
+                    }
+                }
+                out << "}, \"ipc\": " << result.InstructionsPerCycle();
+            }
+            out << "}";
+        }
+        out << "\n  ]\n}" << std::endl;
+    }
+};
+
+}
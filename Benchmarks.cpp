@@ -0,0 +1,504 @@
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+#include "CircularBuffer.h"
+#include "Sort.h"
+#include "CircularBufferSimd.h"
+#include "Benchmark.h"
+
+namespace {
+
+template<typename Buffer>
+void EmplaceBackCase(benchmark::Runner& runner, const std::string& name, Buffer& a, int count) {
+    runner.Run(name, count, [&a, count]() {
+        for (int j = 0; j < count; ++j) {
+            a.EmplaceBack(j);
+        }
+        benchmark::DoNotOptimize(a);
+    });
+}
+
+template<typename Buffer>
+void PushPopCase(benchmark::Runner& runner, const std::string& name, Buffer& a, int count) {
+    runner.Run(name, count, [&a, count]() {
+        for (int j = 0; j < count; ++j) {
+            a.PopFront();
+            a.EmplaceBack(j);
+        }
+        benchmark::DoNotOptimize(a);
+    });
+}
+
+template<typename Buffer>
+void PushReleaseCase(benchmark::Runner& runner, const std::string& name, Buffer& a,
+                     typename Buffer::value_type payload, bool move) {
+    const int count = static_cast<int>(a.Capacity());
+    runner.Run(name, count, [&a, &payload, count, move]() {
+        for (int j = 0; j < count; ++j) {
+            if (move) {
+                a.PushBack(std::move(payload));
+                payload = a.ReleaseFront();
+            } else {
+                a.PushBack(payload);
+                payload = a.GetFront();
+                a.PopFront();
+            }
+        }
+        benchmark::DoNotOptimize(payload);
+    });
+}
+
+struct LageDataStruct {
+    std::variant<double, int> a, b, c, d, f, g, h, i;
+};
+
+void CircBufferBenchmarks(benchmark::Runner& runner) {
+    {
+        CircularBufferArray<int, 128> a;
+        EmplaceBackCase(runner, "StackAllocator_128", a, 128);
+    }
+    {
+        CircularBufferArray<int, 128, int> a;
+        EmplaceBackCase(runner, "HeapAllocator_128", a, 128);
+    }
+    {
+        CircularBufferArray<int, 1024> a;
+        EmplaceBackCase(runner, "StackAllocator_1024", a, 1024);
+    }
+    {
+        CircularBufferArray<int, 1025> a;
+        EmplaceBackCase(runner, "HeapAllocatorMax_1025", a, 1025);
+    }
+    {
+        CircularBufferArray<int, 1024, int> a;
+        EmplaceBackCase(runner, "HeapAllocator_1024", a, 1024);
+    }
+    {
+        CircularBufferArray<LageDataStruct, 32> a;
+        runner.Run("StackAllocator_LageDataStruct_32", 32, [&a]() {
+            for (int j = 0; j < 32; ++j) {
+                a.PushBack({j, j, j, j, j, j, j, j});
+            }
+            benchmark::DoNotOptimize(a);
+        });
+    }
+    {
+        CircularBufferArray<LageDataStruct, 32, int> a;
+        runner.Run("HeapAllocator_LageDataStruct_32", 32, [&a]() {
+            for (int j = 0; j < 32; ++j) {
+                a.PushBack({j, j, j, j, j, j, j, j});
+            }
+            benchmark::DoNotOptimize(a);
+        });
+    }
+
+    // Power of two capacity uses mask-and-add cursor math, the paired run uses compare-and-modulo.
+    {
+        CircularBufferArray<int, 1024, int> a;
+        EmplaceBackCase(runner, "PowerOfTwo_EmplaceBack_1024", a, 1024);
+    }
+    {
+        CircularBufferArray<int, 1000, int> a;
+        EmplaceBackCase(runner, "NonPowerOfTwo_EmplaceBack_1000", a, 1024);
+    }
+    {
+        CircularBufferArray<int, 1024, int> a(0);
+        PushPopCase(runner, "PowerOfTwo_PushPop_1024", a, 1024);
+    }
+    {
+        CircularBufferArray<int, 1000, int> a(0);
+        PushPopCase(runner, "NonPowerOfTwo_PushPop_1000", a, 1024);
+    }
+    {
+        CircularBufferArray<int, 1024, int> a(1);
+        runner.Run("PowerOfTwo_Index_1024", 1024, [&a]() {
+            long long sum = 0;
+            for (size_t j = 0; j < 1024; ++j) {
+                sum += a[j & 1023];
+            }
+            return sum;
+        });
+    }
+    {
+        CircularBufferArray<int, 1000, int> a(1);
+        runner.Run("NonPowerOfTwo_Index_1000", 1024, [&a]() {
+            long long sum = 0;
+            for (size_t j = 0; j < 1024; ++j) {
+                sum += a[j % 1000];
+            }
+            return sum;
+        });
+    }
+    {
+        CircularBufferArray<int, 1024, int> a(1);
+        runner.Run("PowerOfTwo_Iterate_1024", 1024, [&a]() {
+            long long sum = 0;
+            for (int value : a) {
+                sum += value;
+            }
+            return sum;
+        });
+    }
+    {
+        CircularBufferArray<int, 1000, int> a(1);
+        runner.Run("NonPowerOfTwo_Iterate_1000", 1000, [&a]() {
+            long long sum = 0;
+            for (int value : a) {
+                sum += value;
+            }
+            return sum;
+        });
+    }
+
+    // Heap owning payload, moving through the container keeps a single allocation, copying allocates on every step.
+    {
+        CircularBufferArray<std::string, 128, int> a;
+        for (int j = 0; j < 128; ++j) {
+            a.PushBack(std::string(64, 'x'));
+        }
+        PushReleaseCase(runner, "String_PushRelease_Move_128", a, std::string(64, 'x'), true);
+        PushReleaseCase(runner, "String_PushRelease_Copy_128", a, std::string(64, 'x'), false);
+    }
+    {
+        CircularBufferArray<std::vector<int>, 128, int> a;
+        for (int j = 0; j < 128; ++j) {
+            a.PushBack(std::vector<int>(256, j));
+        }
+        PushReleaseCase(runner, "Vector_PushRelease_Move_128", a, std::vector<int>(256, 1), true);
+        PushReleaseCase(runner, "Vector_PushRelease_Copy_128", a, std::vector<int>(256, 1), false);
+    }
+    {
+        CircularBufferArray<std::string, 128, int> a;
+        runner.Run("String_Overwrite_Move_128", 128, [&a]() {
+            for (int j = 0; j < 128; ++j) {
+                a.PushBack(std::string(64, 'x'));
+            }
+            benchmark::DoNotOptimize(a);
+        });
+    }
+}
+
+// Every call sorts a fresh copy of the input, the copy is part of the measured time of every sort.
+// CountingSort allocates a catalog of the whole value range, so it only gets inputs with a narrow range.
+void SortBenchmarks(benchmark::Runner& runner) {
+    const size_t size = size_t(1) << 20;
+    std::mt19937 generator(20);
+    auto make_input = [&generator, size](auto&& next) {
+        std::vector<int> input(size);
+        for (int& value : input) {
+            value = next();
+        }
+        return input;
+    };
+    std::uniform_int_distribution<int> narrow(0, 999);
+    std::uniform_int_distribution<int> medium(-1000000, 1000000);
+    std::uniform_int_distribution<int> wide(INT32_MIN, INT32_MAX);
+    std::exponential_distribution<double> exponential(1e-4);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    std::vector<int> sorted = make_input([&]() { return medium(generator); });
+    std::sort(sorted.begin(), sorted.end());
+    struct Input {
+        const char* name;
+        std::vector<int> values;
+        bool small_values;
+    };
+    const Input inputs[] = {
+        {"Uniform_1K", make_input([&]() { return narrow(generator); }), true},
+        {"Uniform_2M", make_input([&]() { return medium(generator); }), true},
+        {"Uniform_Full", make_input([&]() { return wide(generator); }), false},
+        {"Skewed_Exp", make_input([&]() { return static_cast<int>(exponential(generator)); }), true},
+        {"Outliers_1pct", make_input([&]() {
+            return percent(generator) == 0 ? wide(generator) : narrow(generator);
+        }), false},
+        {"Sorted_2M", sorted, true},
+    };
+
+    std::vector<int> work(size);
+    for (const Input& input : inputs) {
+        const std::string suffix = std::string("_") + input.name + "_1M";
+        if (input.small_values) {
+            runner.Run("CountingSort" + suffix, size, [&work, &input]() {
+                std::copy(input.values.begin(), input.values.end(), work.begin());
+                CountingSort(work);
+                benchmark::DoNotOptimize(work.data());
+            });
+        }
+        runner.Run("HybridSort" + suffix, size, [&work, &input]() {
+            std::copy(input.values.begin(), input.values.end(), work.begin());
+            HybridSort(work);
+            benchmark::DoNotOptimize(work.data());
+        });
+        runner.Run("StdSort" + suffix, size, [&work, &input]() {
+            std::copy(input.values.begin(), input.values.end(), work.begin());
+            std::sort(work.begin(), work.end());
+            benchmark::DoNotOptimize(work.data());
+        });
+    }
+}
+
+template<typename T>
+void RadixSortBenchmarksType(benchmark::Runner& runner, const char* type_name, const std::vector<size_t>& sizes) {
+    std::mt19937_64 generator(22);
+    RadixSorter<T> sorter;
+    RadixSorter<T, 11> sorter_11;
+    for (size_t size : sizes) {
+        std::vector<T> input(size);
+        for (T& value : input) {
+            if constexpr (std::is_integral_v<T>) {
+                value = static_cast<T>(generator());
+            } else {
+                value = static_cast<T>(std::uniform_real_distribution<double>(-1e6, 1e6)(generator));
+            }
+        }
+        std::vector<T> work(size);
+        const std::string suffix = std::string("_") + type_name + "_" + std::to_string(size);
+        auto run = [&](const std::string& name, auto&& sort) {
+            runner.Run(name + suffix, size, [&]() {
+                std::copy(input.begin(), input.end(), work.begin());
+                sort(work);
+                benchmark::DoNotOptimize(work.data());
+            });
+        };
+        run("RadixSort8", [&sorter](std::vector<T>& values) { sorter.Sort(values); });
+        run("RadixSort11", [&sorter_11](std::vector<T>& values) { sorter_11.Sort(values); });
+        run("StdSort", [](std::vector<T>& values) { std::sort(values.begin(), values.end()); });
+        if constexpr (std::is_same_v<T, int>) {
+            // CountingSort catalogs grow with the value range, so it sorts the same count of values from [-1M, 1M]
+            std::uniform_int_distribution<int> medium(-1000000, 1000000);
+            std::vector<int> small_input(size);
+            for (int& value : small_input) value = medium(generator);
+            runner.Run("CountingSort_int32_2M_" + std::to_string(size), size, [&]() {
+                std::copy(small_input.begin(), small_input.end(), work.begin());
+                CountingSort(work);
+                benchmark::DoNotOptimize(work.data());
+            });
+            runner.Run("RadixSort8_int32_2M_" + std::to_string(size), size, [&]() {
+                std::copy(small_input.begin(), small_input.end(), work.begin());
+                sorter.Sort(work);
+                benchmark::DoNotOptimize(work.data());
+            });
+        }
+    }
+}
+
+// Every call sorts a fresh copy of uniformly distributed input over the whole range of integer types.
+void RadixSortBenchmarks(benchmark::Runner& runner) {
+    std::vector<size_t> sizes = {1000, 65536, 1000000, 10000000};
+    if (runner.GetOptions().large) {
+        sizes.push_back(100000000);
+    }
+    RadixSortBenchmarksType<int32_t>(runner, "int32", sizes);
+    RadixSortBenchmarksType<int64_t>(runner, "int64", sizes);
+    RadixSortBenchmarksType<uint32_t>(runner, "uint32", sizes);
+    RadixSortBenchmarksType<uint64_t>(runner, "uint64", sizes);
+    RadixSortBenchmarksType<float>(runner, "float", sizes);
+    RadixSortBenchmarksType<double>(runner, "double", sizes);
+}
+
+// Speedup is the median time of the sequential baseline over the median time of the parallel run.
+void ParallelSortBenchmarks(benchmark::Runner& runner) {
+    std::vector<size_t> sizes = {10000000};
+    if (runner.GetOptions().large) {
+        sizes.push_back(100000000);
+    }
+    std::vector<size_t> thread_counts = {1, 2, 4, 8, 16, 32};
+    std::mt19937_64 generator(23);
+    std::uniform_int_distribution<int> medium(-1000000, 1000000);
+
+    for (size_t size : sizes) {
+        std::vector<int> narrow_input(size);
+        std::vector<int> wide_input(size);
+        for (size_t i = 0; i < size; ++i) {
+            narrow_input[i] = medium(generator);
+            wide_input[i] = static_cast<int>(generator());
+        }
+        std::vector<int> work(size);
+        const std::string suffix = "_" + std::to_string(size);
+        auto run = [&](const std::string& name, const std::vector<int>& input, auto&& sort) -> double {
+            const size_t count = runner.Results().size();
+            runner.Run(name + suffix, size, [&]() {
+                std::copy(input.begin(), input.end(), work.begin());
+                sort(work);
+                benchmark::DoNotOptimize(work.data());
+            });
+            return runner.Results().size() == count ? 0.0 : runner.Results().back().median_ns;
+        };
+        auto report = [&runner, &suffix](const std::string& name, double baseline_ns, const char* baseline, double ns) {
+            if (baseline_ns == 0 || ns == 0) return;
+            runner.Log() << "Speedup of " << name << suffix << " over " << baseline << ": " << baseline_ns / ns
+                         << std::endl;
+        };
+
+        const double counting_ns = run("CountingSort_2M", narrow_input, [](std::vector<int>& values) {
+            CountingSort(values);
+        });
+        RadixSorter<int> sequential;
+        const double radix_ns = run("RadixSort_Full", wide_input, [&sequential](std::vector<int>& values) {
+            sequential.Sort(values);
+        });
+        for (size_t thread_count : thread_counts) {
+            const std::string threads = "_" + std::to_string(thread_count) + "T";
+            const double hybrid_ns = run("ParallelHybridSort_2M" + threads, narrow_input,
+                                         [thread_count](std::vector<int>& values) {
+                                             ParallelHybridSort(values, thread_count);
+                                         });
+            report("ParallelHybridSort_2M" + threads, counting_ns, "CountingSort", hybrid_ns);
+
+            ParallelRadixSorter<int> sorter(thread_count);
+            const double parallel_ns = run("ParallelRadixSort_Full" + threads, wide_input,
+                                           [&sorter](std::vector<int>& values) { sorter.Sort(values); });
+            report("ParallelRadixSort_Full" + threads, radix_ns, "RadixSort", parallel_ns);
+        }
+    }
+}
+
+template<size_t _Size>
+struct BenchmarkRecord {
+    int32_t key;
+    char payload[_Size - sizeof(int32_t)];
+};
+
+template<size_t _Size>
+void SortByKeyBenchmarksSize(benchmark::Runner& runner, size_t size) {
+    using Record = BenchmarkRecord<_Size>;
+    static_assert(sizeof(Record) == _Size, "Record must have no padding");
+    std::mt19937 generator(24);
+    std::uniform_int_distribution<int32_t> keys(0, 1 << 20);
+    std::vector<Record> input(size);
+    for (Record& record : input) {
+        record.key = keys(generator);
+        std::fill(std::begin(record.payload), std::end(record.payload), static_cast<char>(record.key));
+    }
+    std::vector<Record> work(size);
+    auto key = [](const Record& record) { return record.key; };
+    const std::string suffix = "_" + std::to_string(_Size) + "B_" + std::to_string(size);
+
+    runner.Run("SortByKey" + suffix, size, [&]() {
+        std::copy(input.begin(), input.end(), work.begin());
+        SortByKey(work, key);
+        benchmark::DoNotOptimize(work.data());
+    });
+    runner.Run("Argsort" + suffix, size, [&]() {
+        return Argsort(input, key).back();
+    });
+    runner.Run("StdStableSort" + suffix, size, [&]() {
+        std::copy(input.begin(), input.end(), work.begin());
+        std::stable_sort(work.begin(), work.end(), [](const Record& left, const Record& right) {
+            return left.key < right.key;
+        });
+        benchmark::DoNotOptimize(work.data());
+    });
+}
+
+// Histogram phase of counting sort alone on 1M values, then the min/max pre-pass. "Branchy" is the first loop of
+// the original CountingSort, catalogs by sign and absolute value updated together with min and max, allocated up
+// front so it never resizes. "Single" and "Sub4" are BuildHistogram with one and four sub-histograms, above
+// histogram_sub_max_buckets both count into one. Runs of equal values are where sub-histograms help, so every
+// range is also measured on sorted input.
+void HistogramBenchmarks(benchmark::Runner& runner) {
+    const size_t size = size_t(1) << 20;
+    std::mt19937 generator(25);
+    std::vector<int> values(size);
+    std::vector<size_t> histogram;
+
+    for (size_t range : {size_t(256), size_t(4096), size_t(16384), size_t(65536), size_t(1) << 21}) {
+        std::uniform_int_distribution<int> distribution(-static_cast<int>(range / 2), static_cast<int>(range / 2) - 1);
+        for (int& value : values) value = distribution(generator);
+        std::vector<int> catalog_plus(range / 2 + 1);
+        std::vector<int> catalog_minus(range / 2 + 1);
+        histogram.resize(range);
+        const int lo = -static_cast<int>(range / 2);
+        auto bucket = [lo](int value) { return static_cast<size_t>(static_cast<int64_t>(value) - lo); };
+
+        for (const char* order : {"Random", "Sorted"}) {
+            if (order[0] == 'S') std::sort(values.begin(), values.end());
+            const std::string suffix = "_" + std::to_string(range) + "_" + order + "_1M";
+            runner.Run("HistogramBranchy" + suffix, size, [&]() {
+                std::fill(catalog_plus.begin(), catalog_plus.end(), 0);
+                std::fill(catalog_minus.begin(), catalog_minus.end(), 0);
+                int min = INT_MAX, max = INT_MIN;
+                for (int n : values) {
+                    if (n < 0) {
+                        ++catalog_minus[-n];
+                    } else {
+                        ++catalog_plus[n];
+                    }
+                    min = std::min(min, n);
+                    max = std::max(max, n);
+                }
+                benchmark::DoNotOptimize(min);
+                benchmark::DoNotOptimize(max);
+                benchmark::DoNotOptimize(catalog_plus.data());
+                benchmark::DoNotOptimize(catalog_minus.data());
+            });
+            runner.Run("HistogramSingle" + suffix, size, [&]() {
+                BuildHistogram<1>(values.data(), size, range, histogram.data(), bucket);
+                benchmark::DoNotOptimize(histogram.data());
+            });
+            runner.Run("HistogramSub4" + suffix, size, [&]() {
+                BuildHistogram<4>(values.data(), size, range, histogram.data(), bucket);
+                benchmark::DoNotOptimize(histogram.data());
+            });
+        }
+    }
+
+    std::uniform_int_distribution<int> wide(INT32_MIN, INT32_MAX);
+    for (int& value : values) value = wide(generator);
+    runner.Run("MinMaxStd_1M", size, [&values]() {
+        const auto [min_it, max_it] = std::minmax_element(values.begin(), values.end());
+        return static_cast<int64_t>(*min_it) + *max_it;
+    });
+    const std::pair<const char*, simd::Level> levels[] = {
+        {"Scalar", simd::Level::Scalar}, {"Sse2", simd::Level::Sse2}, {"Avx2", simd::Level::Avx2}
+    };
+    for (const auto& [name, level] : levels) {
+        if (level > simd::GetLevel()) continue;
+        runner.Run(std::string("MinMax") + name + "_1M", size, [&values, level = level]() {
+            const auto [min, max] = simd::MinMax(values.data(), values.size(), level);
+            return static_cast<int64_t>(min) + max;
+        });
+    }
+
+}
+
+// Records are a 4-byte key and a payload, every call sorts a fresh copy of the input.
+void SortByKeyBenchmarks(benchmark::Runner& runner) {
+    const size_t size = size_t(1) << 20;
+    SortByKeyBenchmarksSize<8>(runner, size);
+    SortByKeyBenchmarksSize<32>(runner, size);
+    SortByKeyBenchmarksSize<128>(runner, size);
+}
+
+}
+
+int main(int argc, char** argv) {
+    benchmark::Runner runner(benchmark::Runner::ParseOptions(argc, argv));
+
+    CircBufferBenchmarks(runner);
+    SortBenchmarks(runner);
+    RadixSortBenchmarks(runner);
+    ParallelSortBenchmarks(runner);
+    SortByKeyBenchmarks(runner);
+    HistogramBenchmarks(runner);
+
+    const std::string& json_path = runner.GetOptions().json_path;
+    if (json_path == "-") {
+        runner.PrintJson(std::cout);
+    } else if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        if (!out) {
+            std::cerr << "Can not open " << json_path << std::endl;
+            return 1;
+        }
+        runner.PrintJson(out);
+    }
+    return 0;
+}
@@ -8,10 +8,43 @@
 #include <new>
 #include <cstddef>
 #include <tuple>
+#include <atomic>
+#include <algorithm>
+#include <utility>
+#include <memory>
+#include <cstring>
+#include <initializer_list>
+#include <memory_resource>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
 
+/**
+ *  @brief Overflow policies of circular buffers, selected at compile time.
+ *  OverwritePolicy - push to a full container erases the front element.
+ *  RejectPolicy - push to a full container fails, EmplaceBack/PushBack return nullptr.
+ *  GrowPolicy - push to a full container doubles the capacity, supported by CircularBuffer.
+ *  Waiting for free space is not a policy, it needs synchronization and is the separate class
+ *  BlockingCircularBufferArray.
+*/
+struct OverwritePolicy {};
+struct RejectPolicy {};
+struct GrowPolicy {};
+
+/**
+ *  @brief Passed as "IsHeap" parameter, allocates storage in the heap regardless of Size,
+ *  aligned to at least "_Alignment" bytes, e.g. 64 to start the buffer on a cache line or 128 to keep
+ *  it off the line pair fetched by the adjacent line prefetcher.
+*/
+template<std::size_t _Alignment>
+struct AlignedHeap {
+    static_assert(_Alignment != 0 && (_Alignment & (_Alignment - 1)) == 0, "_Alignment must be a power of two");
+};
 
 namespace {
 constexpr std::size_t max_stack_size = 4096;
+constexpr std::size_t cache_line_size = 64;
 
 template<typename T, std::enable_if_t<std::is_integral_v<T>, bool> = true>
 class CyclicRangeValue {
@@ -182,26 +215,163 @@ public:
     }
 };
 
-template<typename T, size_t _Capacity>
+constexpr bool IsPowerOfTwo(std::size_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+/**
+ *  @brief Cyclic value in range [0, _Mask] where _Mask + 1 is a power of two.
+ *  Has the same interface as CyclicRangeValue, but every operation is a single add and mask,
+ *  there are no compares and no modulo.
+ *  @tparam T Unsigned integral type
+ *  @tparam _Mask Range max value
+*/
+template<typename T, T _Mask>
+class CyclicMaskValue {
+    static_assert(std::is_unsigned_v<T>, "T must be unsigned");
+    static_assert(IsPowerOfTwo(_Mask + 1), "_Mask + 1 must be a power of two");
+
+    T current_value_ = 0;
+
+public:
+
+    CyclicMaskValue() = default;
+
+    explicit CyclicMaskValue([[maybe_unused]] T max) {
+        assert(max == _Mask && "max must be equal to _Mask");
+    }
+
+    explicit CyclicMaskValue(T value, [[maybe_unused]] T max) : current_value_(value & _Mask) {
+        assert(max == _Mask && "max must be equal to _Mask");
+    }
+
+    inline T CalculateValue(T value) const {
+        return value & _Mask;
+    }
+
+    CyclicMaskValue operator+(T value) const {
+        CyclicMaskValue temp(*this);
+        temp += value;
+        return temp;
+    }
+
+    CyclicMaskValue operator-(T value) const {
+        CyclicMaskValue temp(*this);
+        temp -= value;
+        return temp;
+    }
+
+    CyclicMaskValue& operator+=(T value) {
+        current_value_ = (current_value_ + value) & _Mask;
+        return *this;
+    }
+
+    CyclicMaskValue& operator-=(T value) {
+        current_value_ = (current_value_ - value) & _Mask;
+        return *this;
+    }
+
+    CyclicMaskValue& operator++() {
+        current_value_ = (current_value_ + 1) & _Mask;
+        return *this;
+    }
+
+    CyclicMaskValue operator++(int) {
+        CyclicMaskValue temp(*this);
+        ++(*this);
+        return temp;
+    }
+
+    CyclicMaskValue& operator--() {
+        current_value_ = (current_value_ - 1) & _Mask;
+        return *this;
+    }
+
+    CyclicMaskValue operator--(int) {
+        CyclicMaskValue temp(*this);
+        --(*this);
+        return temp;
+    }
+
+    operator T() const {
+        return current_value_;
+    }
+
+    bool operator==(const CyclicMaskValue& rhs) const {
+        return current_value_ == rhs.current_value_;
+    }
+    bool operator!=(const CyclicMaskValue& rhs) const {
+        return !(rhs == *this);
+    }
+
+    CyclicMaskValue& SetValue(T value) {
+        current_value_ = value & _Mask;
+        return *this;
+    }
+
+    CyclicMaskValue& ResetValue() {
+        current_value_ = 0;
+        return *this;
+    }
+
+    T GetMin() const { return 0; }
+
+    T GetMax() const { return _Mask; }
+
+    T GetValue() const { return current_value_; }
+
+    T Difference() const {
+        return _Mask;
+    }
+};
+
+/**
+ *  @brief Heap storage policy aligned to alignof(T) or "_Alignment", whichever is greater.
+*/
+template<typename T, size_t _Capacity, size_t _Alignment = alignof(T)>
 class HeapAllocator {
-    alignas(std::max_align_t) std::byte* storage;
+    static constexpr size_t alignment = std::max(_Alignment, alignof(T));
+
+    std::byte* storage;
 
 public:
     HeapAllocator() {
-        storage = new std::byte[(sizeof(T) * _Capacity)];
+        storage = static_cast<std::byte*>(::operator new(sizeof(T) * _Capacity, std::align_val_t(alignment)));
     }
     ~HeapAllocator() {
-        delete[] storage;
+        ::operator delete(storage, std::align_val_t(alignment));
     }
 
+    HeapAllocator(const HeapAllocator&) = delete;
+    HeapAllocator& operator=(const HeapAllocator&) = delete;
+
     T* allocate() noexcept {
         return reinterpret_cast<T*>(storage);
     }
+
+    template<typename... Args>
+    void construct(T* p, Args&& ... args) {
+        new(p) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* p) noexcept {
+        p->~T();
+    }
+
+    /**
+     *  @brief Returns storage for a copy of the container.
+    */
+    HeapAllocator select_on_container_copy_construction() const {
+        return HeapAllocator();
+    }
 };
 
-template<typename T, size_t _Capacity>
+/**
+ *  @brief Storage policy inside the container object aligned to alignof(T) or "_Alignment", whichever is greater.
+*/
+template<typename T, size_t _Capacity, size_t _Alignment = alignof(T)>
 class StackAllocator {
-    alignas(std::max_align_t) std::byte storage[sizeof(T) * _Capacity];
+    alignas(std::max(_Alignment, alignof(T))) std::byte storage[sizeof(T) * _Capacity];
 
 public:
     explicit StackAllocator() = default;
@@ -210,16 +380,136 @@ public:
     T* allocate() noexcept {
         return reinterpret_cast<T*>(storage);
     }
+
+    template<typename... Args>
+    void construct(T* p, Args&& ... args) {
+        new(p) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* p) noexcept {
+        p->~T();
+    }
+
+    /**
+     *  @brief Returns storage for a copy of the container.
+    */
+    StackAllocator select_on_container_copy_construction() const {
+        return StackAllocator();
+    }
+};
+
+/**
+ *  @brief Storage policy on top of a standard allocator (std::allocator_traits interface)
+ *  Allocator is rebound to T, so an allocator of any value type can be passed, including
+ *  std::pmr::polymorphic_allocator or a std::pmr::memory_resource pointer. Elements are constructed and
+ *  destroyed through the allocator, so e.g. std::pmr::string elements use the container's resource.
+*/
+template<typename T, size_t _Capacity, typename Alloc = std::allocator<T>>
+class StandardAllocator {
+    using alloc_traits = typename std::allocator_traits<Alloc>::template rebind_traits<T>;
+
+public:
+    using allocator_type = typename alloc_traits::allocator_type;
+
+private:
+    allocator_type allocator_;
+    T* storage = nullptr;
+
+public:
+    StandardAllocator() : StandardAllocator(allocator_type()) {}
+
+    template<typename OtherAlloc>
+    explicit StandardAllocator(const OtherAlloc& allocator) : allocator_(allocator) {
+        storage = alloc_traits::allocate(allocator_, _Capacity);
+    }
+
+    StandardAllocator(const StandardAllocator&) = delete;
+    StandardAllocator& operator=(const StandardAllocator&) = delete;
+
+    ~StandardAllocator() {
+        alloc_traits::deallocate(allocator_, storage, _Capacity);
+    }
+
+    T* allocate() noexcept {
+        return storage;
+    }
+
+    template<typename... Args>
+    void construct(T* p, Args&& ... args) {
+        alloc_traits::construct(allocator_, p, std::forward<Args>(args)...);
+    }
+
+    void destroy(T* p) noexcept {
+        alloc_traits::destroy(allocator_, p);
+    }
+
+    allocator_type get_allocator() const {
+        return allocator_;
+    }
+
+    /**
+     *  @brief Returns storage for a copy of the container, its allocator is selected as by the standard containers.
+    */
+    StandardAllocator select_on_container_copy_construction() const {
+        return StandardAllocator(alloc_traits::select_on_container_copy_construction(allocator_));
+    }
+};
+
+/**
+ *  @brief Selects the heap storage policy from "IsHeap" parameter of the public containers.
+ *  A standard allocator type selects StandardAllocator, AlignedHeap selects an aligned HeapAllocator,
+ *  anything else selects HeapAllocator.
+*/
+template<typename T, size_t _Capacity, typename IsHeap, typename = void>
+struct HeapStorage {
+    using type = HeapAllocator<T, _Capacity>;
 };
 
-template<typename T, size_t _Capacity, typename Allocator>
+template<typename T, size_t _Capacity, typename Alloc>
+struct HeapStorage<T, _Capacity, Alloc, std::void_t<typename Alloc::value_type>> {
+    using type = StandardAllocator<T, _Capacity, Alloc>;
+};
+
+template<typename T, size_t _Capacity, size_t _Alignment>
+struct HeapStorage<T, _Capacity, AlignedHeap<_Alignment>, void> {
+    using type = HeapAllocator<T, _Capacity, _Alignment>;
+};
+
+/**
+ *  @brief Element storage padded to its own cache line.
+ *  Used by the concurrent containers so that neighbouring elements written by different threads do not
+ *  share a cache line.
+*/
+template<typename T>
+struct alignas(std::max(cache_line_size, alignof(T))) PaddedSlot {
+    std::byte storage[sizeof(T)];
+};
+
+template<typename T, bool _Padded>
+using SlotT = std::conditional_t<_Padded, PaddedSlot<T>, T>;
+
+template<typename T, size_t _Capacity, typename IsHeap>
+using HeapStorageT = typename HeapStorage<T, _Capacity, IsHeap>::type;
+
+template<typename T, size_t _Capacity, typename Allocator, typename OverflowPolicy = OverwritePolicy>
 class CircularBufferArrayBase {
     static_assert(_Capacity > 0, "_Capacity must be greater than 0");
+    static_assert(!std::is_same_v<OverflowPolicy, GrowPolicy>,
+                  "Fixed capacity container can not grow, use CircularBuffer with GrowPolicy");
+    static_assert(std::is_same_v<OverflowPolicy, OverwritePolicy> || std::is_same_v<OverflowPolicy, RejectPolicy>,
+                  "Unknown overflow policy");
+
+    static constexpr bool is_reject = std::is_same_v<OverflowPolicy, RejectPolicy>;
 
 protected:
+    // For power of two capacities cursor math is mask-and-add, otherwise compare-and-modulo.
+    using cursor_type = std::conditional_t<IsPowerOfTwo(_Capacity),
+                                           CyclicMaskValue<size_t, _Capacity - 1>,
+                                           CyclicRangeValue<size_t>>;
+
     Allocator allocator_;
     T* buffer_ = nullptr;
-    CyclicRangeValue<size_t> range_cursor_ = CyclicRangeValue<size_t>((_Capacity-1));
+    cursor_type range_cursor_ = cursor_type(_Capacity - 1);
     size_t fullness_ = 0;
 
     void Destroy() {
@@ -234,40 +524,73 @@ private:
         return range_cursor_.GetValue();
     }
 
+    // Erases the front element of a full container and constructs the new back element in its slot.
+    // If the constructor throws the container stays valid without the erased element.
+    template<typename... Args>
+    inline T* ReplaceFront(Args&& ... args) {
+        cursor_type cursor = range_cursor_;
+        ++cursor;
+        T* cursor_ptr = buffer_ + cursor.GetValue();
+        allocator_.destroy(cursor_ptr);
+        --fullness_;
+        allocator_.construct(cursor_ptr, std::forward<Args>(args)...);
+        range_cursor_ = cursor;
+        ++fullness_;
+        return cursor_ptr;
+    }
+
+    void MoveElements(CircularBufferArrayBase& other) {
+        for (T& value : other) {
+            EmplaceBack(std::move(value));
+        }
+        other.Clear();
+    }
+
     inline size_t GetStart() const {
-        CyclicRangeValue<size_t> tail = range_cursor_;
+        cursor_type tail = range_cursor_;
         tail -= (fullness_ - 1);
         return tail.GetValue();
     }
 
+    /**
+     *  @brief Returns the storage index of the n-th element counting from the front.
+    */
+    inline size_t GetIndex(size_t n) const {
+        cursor_type range_n = range_cursor_;
+        range_n -= (fullness_ - 1);
+        range_n += n;
+        return range_n.GetValue();
+    }
+
     template<typename ValueType>
     class const_iterator_base {
-        const CircularBufferArrayBase* container_ptr_;
-        CyclicRangeValue<size_t> iterator_cursor_;
+        const CircularBufferArrayBase* container_ptr_ = nullptr;
+        size_t offset_ = 0;
 
     public:
-        using iterator_category = std::forward_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
         using value_type = ValueType;
         using difference_type = std::ptrdiff_t;
         using pointer = const value_type*;
         using reference = const value_type&;
 
+        const_iterator_base() = default;
+
         explicit const_iterator_base(const CircularBufferArrayBase* container, size_t offset = 0) noexcept
-            : container_ptr_(container) {
+            : container_ptr_(container), offset_(offset) {
             assert(offset <= container->fullness_ && "Offset must be less than to the fullness.");
-            iterator_cursor_ = CyclicRangeValue<size_t>(offset, container->fullness_);
         }
 
         const_iterator_base(const const_iterator_base& Other)
-            : container_ptr_(Other.container_ptr_), iterator_cursor_(Other.iterator_cursor_) {}
+            : container_ptr_(Other.container_ptr_), offset_(Other.offset_) {}
 
         const_iterator_base(const_iterator_base&& Other) noexcept
-            : container_ptr_(Other.container_ptr_), iterator_cursor_(Other.iterator_cursor_) {}
+            : container_ptr_(Other.container_ptr_), offset_(Other.offset_) {}
 
         const_iterator_base& operator=(const const_iterator_base& Other) {
             if (this == &Other) return *this;
             container_ptr_ = Other.container_ptr_;
-            iterator_cursor_ = Other.iterator_cursor_;
+            offset_ = Other.offset_;
             return *this;
         }
 
@@ -275,20 +598,24 @@ private:
             if (this == &Other)
                 return *this;
             container_ptr_ = Other.container_ptr_;
-            iterator_cursor_ = Other.iterator_cursor_;
+            offset_ = Other.offset_;
             return *this;
         }
 
         reference operator*() const noexcept {
-            return *(container_ptr_->buffer_ + iterator_cursor_.GetValue());
+            return *(container_ptr_->buffer_ + container_ptr_->GetIndex(offset_));
         }
 
         pointer operator->() const noexcept {
-            return container_ptr_->buffer_ + iterator_cursor_.GetValue();
+            return container_ptr_->buffer_ + container_ptr_->GetIndex(offset_);
+        }
+
+        reference operator[](difference_type n) const noexcept {
+            return *(container_ptr_->buffer_ + container_ptr_->GetIndex(offset_ + n));
         }
 
         const_iterator_base& operator++() noexcept {
-            ++iterator_cursor_;
+            ++offset_;
             return *this;
         }
 
@@ -298,13 +625,69 @@ private:
             return Tmp;
         }
 
+        const_iterator_base& operator--() noexcept {
+            --offset_;
+            return *this;
+        }
+
+        const_iterator_base operator--(int) noexcept {
+            const_iterator_base Tmp = *this;
+            --*this;
+            return Tmp;
+        }
+
+        const_iterator_base& operator+=(difference_type n) noexcept {
+            offset_ += n;
+            return *this;
+        }
+
+        const_iterator_base& operator-=(difference_type n) noexcept {
+            offset_ -= n;
+            return *this;
+        }
+
+        const_iterator_base operator+(difference_type n) const noexcept {
+            const_iterator_base Tmp = *this;
+            return Tmp += n;
+        }
+
+        friend const_iterator_base operator+(difference_type n, const const_iterator_base& it) noexcept {
+            return it + n;
+        }
+
+        const_iterator_base operator-(difference_type n) const noexcept {
+            const_iterator_base Tmp = *this;
+            return Tmp -= n;
+        }
+
+        difference_type operator-(const const_iterator_base& rhs) const noexcept {
+            assert(container_ptr_ == rhs.container_ptr_ && "Iterators must belong to the same container.");
+            return static_cast<difference_type>(offset_) - static_cast<difference_type>(rhs.offset_);
+        }
+
         bool operator==(const const_iterator_base& rhs) const {
-            return container_ptr_ == rhs.container_ptr_ && iterator_cursor_ == rhs.iterator_cursor_;
+            return container_ptr_ == rhs.container_ptr_ && offset_ == rhs.offset_;
         }
 
         bool operator!=(const const_iterator_base& rhs) const {
             return !(rhs == *this);
         }
+
+        bool operator<(const const_iterator_base& rhs) const {
+            return offset_ < rhs.offset_;
+        }
+
+        bool operator>(const const_iterator_base& rhs) const {
+            return rhs < *this;
+        }
+
+        bool operator<=(const const_iterator_base& rhs) const {
+            return !(rhs < *this);
+        }
+
+        bool operator>=(const const_iterator_base& rhs) const {
+            return !(*this < rhs);
+        }
     };
 
     template<typename ValueType>
@@ -312,7 +695,7 @@ private:
     public:
         using Super = const_iterator_base<ValueType>;
 
-        using iterator_category = std::forward_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
         using value_type = ValueType;
         using difference_type = std::ptrdiff_t;
         using pointer = value_type*;
@@ -328,6 +711,10 @@ private:
             return &(const_cast<reference>(Super::operator*()));
         }
 
+        reference operator[](difference_type n) const noexcept {
+            return const_cast<reference>(Super::operator[](n));
+        }
+
         iterator_base& operator++() noexcept {
             Super::operator++();
             return *this;
@@ -338,6 +725,43 @@ private:
             Super::operator++();
             return Tmp;
         }
+
+        iterator_base& operator--() noexcept {
+            Super::operator--();
+            return *this;
+        }
+
+        iterator_base operator--(int) noexcept {
+            iterator_base Tmp = *this;
+            Super::operator--();
+            return Tmp;
+        }
+
+        iterator_base& operator+=(difference_type n) noexcept {
+            Super::operator+=(n);
+            return *this;
+        }
+
+        iterator_base& operator-=(difference_type n) noexcept {
+            Super::operator-=(n);
+            return *this;
+        }
+
+        iterator_base operator+(difference_type n) const noexcept {
+            iterator_base Tmp = *this;
+            return Tmp += n;
+        }
+
+        friend iterator_base operator+(difference_type n, const iterator_base& it) noexcept {
+            return it + n;
+        }
+
+        iterator_base operator-(difference_type n) const noexcept {
+            iterator_base Tmp = *this;
+            return Tmp -= n;
+        }
+
+        using Super::operator-;
     };
 
 public:
@@ -346,6 +770,15 @@ public:
         buffer_ = allocator_.allocate();
     }
 
+    /**
+     *  @brief Construct the storage policy from "allocator_args", e.g. a standard allocator or a memory resource.
+    */
+    template<typename... AllocatorArgs>
+    explicit CircularBufferArrayBase(std::allocator_arg_t, AllocatorArgs&& ... allocator_args)
+        : allocator_(std::forward<AllocatorArgs>(allocator_args)...) {
+        buffer_ = allocator_.allocate();
+    }
+
     template<typename It>
     CircularBufferArrayBase(It begin, It end) : CircularBufferArrayBase() {
         It iter = begin;
@@ -370,11 +803,68 @@ public:
         }
     }
 
+    /**
+     *  @brief Copy elements of "other", the storage policy of the copy comes from
+     *  "other"'s select_on_container_copy_construction, so a standard allocator is kept or replaced as by the
+     *  standard containers.
+    */
+    CircularBufferArrayBase(const CircularBufferArrayBase& other)
+        : allocator_(other.allocator_.select_on_container_copy_construction()) {
+        buffer_ = allocator_.allocate();
+        try {
+            for (const T& value : other) {
+                EmplaceBack(value);
+            }
+        } catch (...) {
+            Destroy();
+            throw;
+        }
+    }
+
+    /**
+     *  @brief Elements are moved one by one into own storage, "other" is left empty.
+    */
+    CircularBufferArrayBase(CircularBufferArrayBase&& other) : CircularBufferArrayBase() {
+        MoveElements(other);
+    }
+
+    /**
+     *  @brief Copy elements of "other".
+     *  If a copy throws the container holds the elements copied before it.
+    */
+    CircularBufferArrayBase& operator=(const CircularBufferArrayBase& other) {
+        if (this != &other) {
+            Clear();
+            for (const T& value : other) {
+                EmplaceBack(value);
+            }
+        }
+        return *this;
+    }
+
+    /**
+     *  @brief Move elements of "other" one by one, "other" is left empty.
+    */
+    CircularBufferArrayBase& operator=(CircularBufferArrayBase&& other) {
+        if (this != &other) {
+            Clear();
+            MoveElements(other);
+        }
+        return *this;
+    }
+
     virtual ~CircularBufferArrayBase() {
         if (fullness_ == 0) return;
         Destroy();
     }
 
+    /**
+     *  @brief Returns a copy of the allocator associated with the container, only with standard allocator storage.
+    */
+    auto GetAllocator() const {
+        return allocator_.get_allocator();
+    }
+
     using value_type = T;
     using pointer = value_type*;
     using const_pointer = const value_type*;
@@ -385,32 +875,41 @@ public:
 
     /**
      *  @brief Emplace element in container on cursor position
-     *  @return T*  A pointer to the construct element.
+     *  If the constructor throws the container is unchanged.
+     *  @return T*  A pointer to the construct element, nullptr if the container is full with RejectPolicy.
     */
     template<typename... Args>
     inline pointer EmplaceBack(Args&& ... args) {
-        if (fullness_ != 0) {
-            ++range_cursor_;
-        }
-        T* cursor_ptr = buffer_ + range_cursor_.GetValue();
-
         if (fullness_ == _Capacity) {
-            cursor_ptr->~T();
-        } else {
-            ++fullness_;
+            if constexpr (is_reject) {
+                return nullptr;
+            } else if constexpr (std::is_trivially_destructible_v<T> && std::is_nothrow_constructible_v<T, Args&& ...>) {
+                return ReplaceFront(std::forward<Args>(args)...);
+            } else {
+                // Arguments may throw or refer to the overwritten front element, build the element before it is erased
+                T value(std::forward<Args>(args)...);
+                return ReplaceFront(std::move(value));
+            }
         }
-
-        new(cursor_ptr) T(std::forward<Args>(args)...);
+        cursor_type cursor = range_cursor_;
+        if (fullness_ != 0) {
+            ++cursor;
+        }
+        T* cursor_ptr = buffer_ + cursor.GetValue();
+        allocator_.construct(cursor_ptr, std::forward<Args>(args)...);
+        range_cursor_ = cursor;
+        ++fullness_;
         return cursor_ptr;
     }
 
     /**
      *  @brief Push element in container on cursor position
-     *  @return T*  A pointer to the copied element.
+     *  Rvalues are moved in, lvalues are copied.
+     *  @return T*  A pointer to the pushed element.
     */
     template<typename U = T>
     inline pointer PushBack(U&& value) {
-        return EmplaceBack(std::forward<T>(value));
+        return EmplaceBack(std::forward<U>(value));
     }
 
     /**
@@ -419,7 +918,7 @@ public:
     */
     inline void PopFront() {
         pointer head_ptr = buffer_ + GetStart();
-        head_ptr->~value_type();
+        allocator_.destroy(head_ptr);
         --fullness_;
     }
 
@@ -431,7 +930,7 @@ public:
         assert(0 < fullness_ && "Fullness must be greater than 0");
 
         pointer head_ptr = buffer_ + GetCursor();
-        head_ptr->~value_type();
+        allocator_.destroy(head_ptr);
         --range_cursor_;
         --fullness_;
     }
@@ -444,32 +943,127 @@ public:
         return *(buffer_ + GetStart());
     }
 
-    /**
-     *  @brief Returns a reference to the element at the back position in the container.
-    */
+    inline const_reference GetFront() const {
+        assert(0 < fullness_ && "Fullness must be greater than 0");
+        return *(buffer_ + GetStart());
+    }
+
+    /**
+     *  @brief Returns a reference to the element at the back position in the container.
+    */
     inline reference GetBack() {
         assert(0 < fullness_ && "Fullness must be greater than 0");
         return *(buffer_ + GetCursor());
     }
 
+    inline const_reference GetBack() const {
+        assert(0 < fullness_ && "Fullness must be greater than 0");
+        return *(buffer_ + GetCursor());
+    }
+
     /**
-     *  @brief Returns a copy of the element at the front position in the container.
+     *  @brief Returns the front element moved out of the container.
      *  Element will be erased from the container
      */
     inline value_type ReleaseFront() {
-        value_type temp = GetFront();
+        value_type temp = std::move(GetFront());
         PopFront();
-        return std::move(temp);
+        return temp;
     }
 
     /**
-     *  @brief Returns a copy of the element at the back position in the container.
+     *  @brief Returns the back element moved out of the container.
      *  Element will be erased from the container
      */
     inline value_type ReleaseBack() {
-        value_type temp = GetBack();
+        value_type temp = std::move(GetBack());
         PopBack();
-        return std::move(temp);
+        return temp;
+    }
+
+    /**
+     *  @brief Push elements of [first, last) at the back of the container.
+     *  When there are more elements than free space, front elements are overwritten as with EmplaceBack,
+     *  with RejectPolicy only the elements that fit are pushed.
+     *  Pointer ranges of trivially copyable T are copied with at most two memcpy calls.
+     *  @return Count of pushed elements.
+    */
+    template<typename It>
+    inline size_t PushBackRange(It first, It last) {
+        if constexpr (std::is_pointer_v<It> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<It>>, T>) {
+            return PushBackRange(first, static_cast<size_t>(last - first));
+        } else {
+            size_t count = 0;
+            for (; first != last; ++first, ++count) {
+                if constexpr (is_reject) {
+                    if (fullness_ == _Capacity) break;
+                }
+                EmplaceBack(*first);
+            }
+            return count;
+        }
+    }
+
+    /**
+     *  @brief Push "count" elements starting at "data" at the back of the container.
+     *  When there are more elements than free space, front elements are overwritten as with EmplaceBack,
+     *  with RejectPolicy only the elements that fit are pushed.
+     *  Trivially copyable T is copied with at most two memcpy calls, split at the wrap point.
+     *  @return Count of pushed elements.
+    */
+    inline size_t PushBackRange(const T* data, size_t count) {
+        if constexpr (is_reject) {
+            count = std::min(count, _Capacity - fullness_);
+        }
+        const size_t pushed = count;
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (count == 0) return 0;
+            if (count > _Capacity) {
+                data += count - _Capacity;
+                count = _Capacity;
+            }
+            cursor_type write_cursor = range_cursor_;
+            if (fullness_ != 0) {
+                ++write_cursor;
+            }
+            const size_t write_index = write_cursor.GetValue();
+            const size_t first_count = std::min(count, _Capacity - write_index);
+            std::memcpy(buffer_ + write_index, data, first_count * sizeof(T));
+            std::memcpy(buffer_, data + first_count, (count - first_count) * sizeof(T));
+            write_cursor += count - 1;
+            range_cursor_ = write_cursor;
+            fullness_ = std::min(fullness_ + count, _Capacity);
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                EmplaceBack(data[i]);
+            }
+        }
+        return pushed;
+    }
+
+    /**
+     *  @brief Move up to "count" front elements to "out" and erase them from the container.
+     *  Trivially copyable T written to a pointer is copied with at most two memcpy calls, split at the wrap point.
+     *  @return Count of moved elements.
+    */
+    template<typename OutIt>
+    inline size_t PopFrontInto(OutIt out, size_t count) {
+        count = std::min(count, fullness_);
+        if constexpr (std::is_pointer_v<OutIt> && std::is_same_v<std::remove_pointer_t<OutIt>, T>
+                      && std::is_trivially_copyable_v<T>) {
+            if (count == 0) return 0;
+            const size_t start = GetStart();
+            const size_t first_count = std::min(count, _Capacity - start);
+            std::memcpy(out, buffer_ + start, first_count * sizeof(T));
+            std::memcpy(out + first_count, buffer_, (count - first_count) * sizeof(T));
+            fullness_ -= count;
+        } else {
+            for (size_t i = 0; i < count; ++i, ++out) {
+                *out = std::move(GetFront());
+                PopFront();
+            }
+        }
+        return count;
     }
 
     /**
@@ -491,7 +1085,7 @@ public:
     */
     inline void Clear() {
         Destroy();
-        range_cursor_ = CyclicRangeValue<size_t>(_Capacity);
+        range_cursor_ = cursor_type(_Capacity - 1);
     }
 
     /**
@@ -509,15 +1103,131 @@ public:
     }
 
     reference operator[](size_t n) {
-        assert(0 <= n && n < fullness_ && "n must be less than fullness.");
-        CyclicRangeValue<size_t> range_n = range_cursor_;
-        range_n -= (fullness_ - 1);
-        range_n += n;
-        return *(buffer_ + range_n.GetValue());
+        assert(n < fullness_ && "n must be less than fullness.");
+        return *(buffer_ + GetIndex(n));
+    }
+
+    const_reference operator[](size_t n) const {
+        assert(n < fullness_ && "n must be less than fullness.");
+        return *(buffer_ + GetIndex(n));
+    }
+
+    using array_range = std::pair<pointer, size_type>;
+    using const_array_range = std::pair<const_pointer, size_type>;
+
+    /**
+     *  @brief Returns the first contiguous segment of the contents: pointer to the front element and its length.
+    */
+    inline array_range ArrayOne() {
+        if (fullness_ == 0) return {buffer_, 0};
+        const size_t start = GetStart();
+        return {buffer_ + start, std::min(fullness_, _Capacity - start)};
+    }
+
+    /**
+     *  @brief Returns the wrapped contiguous segment of the contents, it starts at the beginning of the storage.
+     *  Length is 0 if the contents are contiguous.
+    */
+    inline array_range ArrayTwo() {
+        if (fullness_ == 0) return {buffer_, 0};
+        const size_t start = GetStart();
+        return {buffer_, fullness_ - std::min(fullness_, _Capacity - start)};
+    }
+
+    inline const_array_range ArrayOne() const {
+        return const_cast<CircularBufferArrayBase*>(this)->ArrayOne();
+    }
+
+    inline const_array_range ArrayTwo() const {
+        return const_cast<CircularBufferArrayBase*>(this)->ArrayTwo();
+    }
+
+    /**
+     *  @brief Call "func(pointer, size)" for each non-empty contiguous segment of the contents, front segment first.
+    */
+    template<typename Func>
+    inline void ForEachSegment(Func&& func) {
+        if (fullness_ == 0) return;
+        const size_t start = GetStart();
+        const size_t first_count = std::min(fullness_, _Capacity - start);
+        func(buffer_ + start, first_count);
+        if (first_count < fullness_) {
+            func(buffer_, fullness_ - first_count);
+        }
+    }
+
+    template<typename Func>
+    inline void ForEachSegment(Func&& func) const {
+        const_cast<CircularBufferArrayBase*>(this)->ForEachSegment([&func](const_pointer data, size_type size) {
+            func(data, size);
+        });
+    }
+
+    /**
+     *  @brief Call "func(element)" for each element from the front to the back.
+     *  Runs one plain pointer loop per contiguous segment, there is no wrap check inside the loops,
+     *  so the compiler can vectorize the body.
+    */
+    template<typename Func>
+    inline void ForEach(Func&& func) {
+        ForEachSegment([&func](pointer data, size_type size) {
+            for (pointer it = data, end = data + size; it != end; ++it) {
+                func(*it);
+            }
+        });
+    }
+
+    template<typename Func>
+    inline void ForEach(Func&& func) const {
+        ForEachSegment([&func](const_pointer data, size_type size) {
+            for (const_pointer it = data, end = data + size; it != end; ++it) {
+                func(*it);
+            }
+        });
+    }
+
+    /**
+     *  @brief Returns true if the contents are one contiguous segment.
+    */
+    inline bool IsLinearized() const {
+        return fullness_ == 0 || GetStart() + fullness_ <= _Capacity;
+    }
+
+    /**
+     *  @brief Rotate the storage in place so the contents become one contiguous segment starting at the storage begin.
+     *  Contents that are already contiguous are not moved. Element moves must not throw.
+     *  @return The contents as one segment.
+    */
+    array_range Linearize() {
+        if (IsLinearized()) {
+            return ArrayOne();
+        }
+        const size_t start = GetStart();
+        const size_t first_count = _Capacity - start;
+        const size_t second_count = fullness_ - first_count;
+        if (fullness_ < _Capacity) {
+            // Close the gap between the segments: shift the first segment down to the end of the second one.
+            const size_t gap = start - second_count;
+            const size_t uninitialized_count = std::min(first_count, gap);
+            T* source = buffer_ + start;
+            T* destination = buffer_ + second_count;
+            for (size_t i = 0; i < uninitialized_count; ++i) {
+                allocator_.construct(destination + i, std::move(source[i]));
+            }
+            std::move(source + uninitialized_count, source + first_count, destination + uninitialized_count);
+            for (size_t i = std::max(start, fullness_); i < _Capacity; ++i) {
+                allocator_.destroy(buffer_ + i);
+            }
+        }
+        std::rotate(buffer_, buffer_ + second_count, buffer_ + fullness_);
+        range_cursor_.SetValue(fullness_ - 1);
+        return {buffer_, fullness_};
     }
 
     using iterator = iterator_base<value_type>;
     using const_iterator = const_iterator_base<value_type>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
     /**
      *  @brief Returns an iterator to the beginning of the container.
@@ -560,6 +1270,48 @@ public:
     const_iterator end() const noexcept {
         return cend();
     }
+
+    /**
+     *  @brief Returns a reverse iterator to the back of the container.
+     */
+    reverse_iterator rbegin() noexcept {
+        return reverse_iterator(end());
+    }
+
+    /**
+     *  @brief Returns a reverse iterator to the element before the front of the container.
+     */
+    reverse_iterator rend() noexcept {
+        return reverse_iterator(begin());
+    }
+
+    /**
+     *  @brief Returns a const reverse iterator to the back of the container.
+     */
+    const_reverse_iterator crbegin() const noexcept {
+        return const_reverse_iterator(cend());
+    }
+
+    /**
+     *  @brief Returns a const reverse iterator to the element before the front of the container.
+     */
+    const_reverse_iterator crend() const noexcept {
+        return const_reverse_iterator(cbegin());
+    }
+
+    /**
+     *  @brief Returns a const reverse iterator to the back of the container.
+     */
+    const_reverse_iterator rbegin() const noexcept {
+        return crbegin();
+    }
+
+    /**
+     *  @brief Returns a const reverse iterator to the element before the front of the container.
+     */
+    const_reverse_iterator rend() const noexcept {
+        return crend();
+    }
 };
 }
 
@@ -568,14 +1320,18 @@ public:
  *  Allocate data in heap
  *  @tparam T Type
  *  @tparam Capacity Container max Size
- *  @tparam IsHeap If "int", it is allocated in the heap regardless of Size
+ *  @tparam IsHeap If "int", it is allocated in the heap regardless of Size.
+ *  If a standard allocator, storage is allocated with it regardless of Size.
+ *  If AlignedHeap, it is allocated in the heap with the given alignment.
+ *  @tparam OverflowPolicy OverwritePolicy or RejectPolicy
 */
-template<typename T, std::size_t _Capacity, typename IsHeap = bool>
-class CircularBufferArray : public CircularBufferArrayBase<T, _Capacity, HeapAllocator<T, _Capacity>> {
+template<typename T, std::size_t _Capacity, typename IsHeap = bool, typename OverflowPolicy = OverwritePolicy>
+class CircularBufferArray
+    : public CircularBufferArrayBase<T, _Capacity, HeapStorageT<T, _Capacity, IsHeap>, OverflowPolicy> {
 public:
     static_assert(_Capacity != 0, "_Capacity must be greater than 0");
 
-    using Super = CircularBufferArrayBase<T, _Capacity, HeapAllocator<T, _Capacity>>;
+    using Super = CircularBufferArrayBase<T, _Capacity, HeapStorageT<T, _Capacity, IsHeap>, OverflowPolicy>;
     using Super::Super;
 };
 
@@ -585,17 +1341,1392 @@ public:
  *  Max stack Size = 1024 byte
  *  @tparam T Type
  *  @tparam Capacity Container max Size
+ *  @tparam OverflowPolicy OverwritePolicy or RejectPolicy
 */
-template<typename T, std::size_t _Capacity>
-class CircularBufferArray<T, _Capacity, std::enable_if_t<(0 < _Capacity && (_Capacity * sizeof(T)) <= max_stack_size), bool>>
-    : public CircularBufferArrayBase<T, _Capacity, StackAllocator<T, _Capacity>> {
+template<typename T, std::size_t _Capacity, typename OverflowPolicy>
+class CircularBufferArray<T, _Capacity, std::enable_if_t<(0 < _Capacity && (_Capacity * sizeof(T)) <= max_stack_size), bool>, OverflowPolicy>
+    : public CircularBufferArrayBase<T, _Capacity, StackAllocator<T, _Capacity>, OverflowPolicy> {
+
+public:
+    using Super = CircularBufferArrayBase<T, _Capacity, StackAllocator<T, _Capacity>, OverflowPolicy>;
+    using Super::Super;
+};
+
+
+namespace {
+
+/**
+ *  @brief Position arithmetic of single-producer/single-consumer circular buffers
+ *  Positions run over [0, 2 * _Capacity) so a full buffer can be told apart from an empty one
+ *  without wasting a slot and without a modulo.
+*/
+template<size_t _Capacity>
+struct SpscPosition {
+    static inline size_t Advance(size_t position) {
+        if constexpr (IsPowerOfTwo(_Capacity)) {
+            return (position + 1) & (2 * _Capacity - 1);
+        } else {
+            ++position;
+            return position == 2 * _Capacity ? 0 : position;
+        }
+    }
+
+    static inline size_t GetIndex(size_t position) {
+        if constexpr (IsPowerOfTwo(_Capacity)) {
+            return position & (_Capacity - 1);
+        } else {
+            return position < _Capacity ? position : position - _Capacity;
+        }
+    }
+
+    static inline size_t Distance(size_t head, size_t tail) {
+        if constexpr (IsPowerOfTwo(_Capacity)) {
+            return (tail - head) & (2 * _Capacity - 1);
+        } else {
+            return head <= tail ? tail - head : tail + 2 * _Capacity - head;
+        }
+    }
+};
+
+/**
+ *  @brief Lock-free single-producer/single-consumer circular buffer
+ *  Positions run over [0, 2 * _Capacity), see SpscPosition.
+ *  Head is written only by the consumer, tail only by the producer, each lives on its own cache line
+ *  together with the owner's cached copy of the opposite position.
+ *  With "_PaddedSlots" every element is stored on its own cache line.
+*/
+template<typename T, size_t _Capacity, typename Allocator, bool _PaddedSlots = false>
+class SpscCircularBufferArrayBase {
+    static_assert(_Capacity > 0, "_Capacity must be greater than 0");
+
+protected:
+    using slot_type = SlotT<T, _PaddedSlots>;
+
+    Allocator allocator_;
+    slot_type* buffer_ = nullptr;
+
+    // Consumer side
+    alignas(cache_line_size) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+
+    // Producer side
+    alignas(cache_line_size) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;
+
+private:
+    using Position = SpscPosition<_Capacity>;
+
+    inline T* GetSlot(size_t position) const {
+        return reinterpret_cast<T*>(buffer_ + Position::GetIndex(position));
+    }
+
+public:
+
+    explicit SpscCircularBufferArrayBase() {
+        buffer_ = allocator_.allocate();
+    }
+
+    /**
+     *  @brief Construct the storage policy from "allocator_args", e.g. a standard allocator or a memory resource.
+    */
+    template<typename... AllocatorArgs>
+    explicit SpscCircularBufferArrayBase(std::allocator_arg_t, AllocatorArgs&& ... allocator_args)
+        : allocator_(std::forward<AllocatorArgs>(allocator_args)...) {
+        buffer_ = allocator_.allocate();
+    }
+
+    SpscCircularBufferArrayBase(const SpscCircularBufferArrayBase&) = delete;
+    SpscCircularBufferArrayBase& operator=(const SpscCircularBufferArrayBase&) = delete;
+
+    virtual ~SpscCircularBufferArrayBase() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        while (head != tail) {
+            GetSlot(head)->~T();
+            head = Position::Advance(head);
+        }
+    }
+
+    using value_type = T;
+    using size_type = std::size_t;
+
+    /**
+     *  @brief Construct element at the back of the container. Producer thread only.
+     *  @return false if the container is full, nothing is constructed in that case.
+    */
+    template<typename... Args>
+    inline bool TryEmplace(Args&& ... args) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (Position::Distance(cached_head_, tail) == _Capacity) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (Position::Distance(cached_head_, tail) == _Capacity) {
+                return false;
+            }
+        }
+        new(GetSlot(tail)) T(std::forward<Args>(args)...);
+        tail_.store(Position::Advance(tail), std::memory_order_release);
+        return true;
+    }
+
+    /**
+     *  @brief Push element at the back of the container. Producer thread only.
+     *  @return false if the container is full.
+    */
+    template<typename U = T>
+    inline bool TryPush(U&& value) {
+        return TryEmplace(std::forward<U>(value));
+    }
+
+    /**
+     *  @brief Move the front element to "value" and erase it. Consumer thread only.
+     *  @return false if the container is empty, "value" is untouched in that case.
+    */
+    inline bool TryPop(T& value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        T* head_ptr = GetSlot(head);
+        value = std::move(*head_ptr);
+        head_ptr->~T();
+        head_.store(Position::Advance(head), std::memory_order_release);
+        return true;
+    }
+
+    /**
+     *  @brief Returns count of elements in the container.
+     *  The value is exact only when called from the producer or the consumer thread while the other one is idle.
+    */
+    inline size_t Size() const {
+        return Position::Distance(head_.load(std::memory_order_acquire), tail_.load(std::memory_order_acquire));
+    }
+
+    /**
+     *  @brief Returns Capacity of the container.
+    */
+    inline size_t Capacity() const {
+        return _Capacity;
+    }
+
+    /**
+     *  @brief Returns true if the container is empty.
+    */
+    inline bool IsEmpty() const {
+        return Size() == 0;
+    }
+
+    /**
+     *  @brief Returns true if the container is full.
+    */
+    inline bool IsFull() const {
+        return Size() == _Capacity;
+    }
+};
+
+}
+
+/**
+ *  @brief Single-producer/single-consumer Circular Buffer Array
+ *  Allocate data in heap
+ *  @tparam T Type
+ *  @tparam Capacity Container max Size
+ *  @tparam IsHeap If "int", it is allocated in the heap regardless of Size.
+ *  If a standard allocator, storage is allocated with it regardless of Size.
+ *  If AlignedHeap, it is allocated in the heap with the given alignment.
+ *  @tparam PaddedSlots If true, every element is stored on its own cache line.
+*/
+template<typename T, std::size_t _Capacity, typename IsHeap = bool, bool _PaddedSlots = false>
+class SpscCircularBufferArray
+    : public SpscCircularBufferArrayBase<T, _Capacity, HeapStorageT<SlotT<T, _PaddedSlots>, _Capacity, IsHeap>, _PaddedSlots> {
+public:
+    static_assert(_Capacity != 0, "_Capacity must be greater than 0");
+
+    using Super = SpscCircularBufferArrayBase<T, _Capacity, HeapStorageT<SlotT<T, _PaddedSlots>, _Capacity, IsHeap>, _PaddedSlots>;
+    using Super::Super;
+};
+
+/**
+ *  @brief Single-producer/single-consumer Circular Buffer Array
+ *  Allocate data in stack
+ *  @tparam T Type
+ *  @tparam Capacity Container max Size
+ *  @tparam PaddedSlots If true, every element is stored on its own cache line.
+*/
+template<typename T, std::size_t _Capacity, bool _PaddedSlots>
+class SpscCircularBufferArray<T, _Capacity, std::enable_if_t<(0 < _Capacity && (_Capacity * sizeof(SlotT<T, _PaddedSlots>)) <= max_stack_size), bool>, _PaddedSlots>
+    : public SpscCircularBufferArrayBase<T, _Capacity, StackAllocator<SlotT<T, _PaddedSlots>, _Capacity>, _PaddedSlots> {
 
 public:
-    using Super = CircularBufferArrayBase<T, _Capacity, StackAllocator<T, _Capacity>>;
+    using Super = SpscCircularBufferArrayBase<T, _Capacity, StackAllocator<SlotT<T, _PaddedSlots>, _Capacity>, _PaddedSlots>;
     using Super::Super;
 };
 
 
 namespace {
 
-}
\ No newline at end of file
+/**
+ *  @brief Slot of MpmcCircularBufferArray: sequence number and raw storage for one element.
+ *  "skipped" marks a slot published without an element because its constructor threw.
+ *  With "_Padded" every cell is stored on its own cache line.
+*/
+template<typename T, bool _Padded = false>
+struct alignas(_Padded ? std::max({cache_line_size, alignof(T), alignof(std::atomic<size_t>)})
+                       : std::max(alignof(T), alignof(std::atomic<size_t>))) MpmcCell {
+    std::atomic<size_t> sequence;
+    bool skipped;
+    alignas(T) std::byte storage[sizeof(T)];
+
+    T* Get() noexcept {
+        return std::launder(reinterpret_cast<T*>(storage));
+    }
+};
+
+/**
+ *  @brief Bounded multi-producer/multi-consumer circular buffer with per-slot sequence numbers
+ *  Slot at position "pos" is free for a producer when its sequence is "pos" and holds an element
+ *  for a consumer when its sequence is "pos + 1". Producers and consumers only contend on their own
+ *  position counter, which live on separate cache lines. With "_PaddedSlots" every slot is stored on
+ *  its own cache line too.
+ *  If an element constructor throws, its claimed slot is published as skipped and the exception is
+ *  rethrown, consumers release skipped slots and step over them, so later elements are not lost.
+ *  Size counts a skipped slot until a consumer steps over it.
+*/
+template<typename T, size_t _Capacity, typename Allocator, bool _PaddedSlots = false>
+class MpmcCircularBufferArrayBase {
+    static_assert(_Capacity > 0, "_Capacity must be greater than 0");
+
+protected:
+    using cell_type = MpmcCell<T, _PaddedSlots>;
+
+    Allocator allocator_;
+    cell_type* cells_ = nullptr;
+
+    alignas(cache_line_size) std::atomic<size_t> enqueue_pos_{0};
+    alignas(cache_line_size) std::atomic<size_t> dequeue_pos_{0};
+
+private:
+
+    static inline size_t GetIndex(size_t position) {
+        if constexpr (IsPowerOfTwo(_Capacity)) {
+            return position & (_Capacity - 1);
+        } else {
+            return position % _Capacity;
+        }
+    }
+
+    static inline std::ptrdiff_t Difference(size_t sequence, size_t position) {
+        return static_cast<std::ptrdiff_t>(sequence - position);
+    }
+
+    /**
+     *  @brief Claims up to "max_count" consecutive positions from "position_counter".
+     *  "ready_offset" is 0 for producers and 1 for consumers.
+     *  @return First claimed position and count of claimed positions.
+    */
+    inline std::pair<size_t, size_t> Claim(std::atomic<size_t>& position_counter, size_t ready_offset, size_t max_count) {
+        size_t position = position_counter.load(std::memory_order_relaxed);
+        while (true) {
+            size_t count = 0;
+            std::ptrdiff_t dif = 0;
+            while (count < max_count && count < _Capacity) {
+                size_t sequence = cells_[GetIndex(position + count)].sequence.load(std::memory_order_acquire);
+                dif = Difference(sequence, position + count + ready_offset);
+                if (dif != 0) break;
+                ++count;
+            }
+            if (count == 0) {
+                if (dif < 0) {
+                    return {position, 0};
+                }
+                position = position_counter.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (position_counter.compare_exchange_weak(position, position + count, std::memory_order_relaxed)) {
+                return {position, count};
+            }
+        }
+    }
+
+    // Publish "count" claimed positions from "position" without elements, consumers step over them.
+    inline void Skip(size_t position, size_t count) noexcept {
+        for (size_t i = 0; i < count; ++i) {
+            cell_type& cell = cells_[GetIndex(position + i)];
+            cell.skipped = true;
+            cell.sequence.store(position + i + 1, std::memory_order_release);
+        }
+    }
+
+    void InitCells() {
+        cells_ = allocator_.allocate();
+        for (size_t i = 0; i < _Capacity; ++i) {
+            new(&cells_[i].sequence) std::atomic<size_t>(i);
+            cells_[i].skipped = false;
+        }
+    }
+
+public:
+
+    explicit MpmcCircularBufferArrayBase() {
+        InitCells();
+    }
+
+    /**
+     *  @brief Construct the storage policy from "allocator_args", e.g. a standard allocator or a memory resource.
+    */
+    template<typename... AllocatorArgs>
+    explicit MpmcCircularBufferArrayBase(std::allocator_arg_t, AllocatorArgs&& ... allocator_args)
+        : allocator_(std::forward<AllocatorArgs>(allocator_args)...) {
+        InitCells();
+    }
+
+    MpmcCircularBufferArrayBase(const MpmcCircularBufferArrayBase&) = delete;
+    MpmcCircularBufferArrayBase& operator=(const MpmcCircularBufferArrayBase&) = delete;
+
+    virtual ~MpmcCircularBufferArrayBase() {
+        size_t position = dequeue_pos_.load(std::memory_order_relaxed);
+        const size_t end = enqueue_pos_.load(std::memory_order_relaxed);
+        for (; position != end; ++position) {
+            cell_type& cell = cells_[GetIndex(position)];
+            if (!cell.skipped) {
+                cell.Get()->~T();
+            }
+        }
+        for (size_t i = 0; i < _Capacity; ++i) {
+            cells_[i].sequence.~atomic();
+        }
+    }
+
+    using value_type = T;
+    using size_type = std::size_t;
+
+    /**
+     *  @brief Construct element at the back of the container.
+     *  @return false if the container is full, nothing is constructed in that case.
+    */
+    template<typename... Args>
+    inline bool TryEmplace(Args&& ... args) {
+        auto [position, count] = Claim(enqueue_pos_, 0, 1);
+        if (count == 0) {
+            return false;
+        }
+        cell_type& cell = cells_[GetIndex(position)];
+        try {
+            new(cell.storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            Skip(position, 1);
+            throw;
+        }
+        cell.sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     *  @brief Push element at the back of the container.
+     *  @return false if the container is full.
+    */
+    template<typename U = T>
+    inline bool TryPush(U&& value) {
+        return TryEmplace(std::forward<U>(value));
+    }
+
+    /**
+     *  @brief Move the front element to "value" and erase it.
+     *  @return false if the container is empty, "value" is untouched in that case.
+    */
+    inline bool TryPop(T& value) {
+        while (true) {
+            auto [position, count] = Claim(dequeue_pos_, 1, 1);
+            if (count == 0) {
+                return false;
+            }
+            cell_type& cell = cells_[GetIndex(position)];
+            if (cell.skipped) {
+                cell.skipped = false;
+                cell.sequence.store(position + _Capacity, std::memory_order_release);
+                continue;
+            }
+            T* element = cell.Get();
+            value = std::move(*element);
+            element->~T();
+            cell.sequence.store(position + _Capacity, std::memory_order_release);
+            return true;
+        }
+    }
+
+    /**
+     *  @brief Push as many elements from [first, last) as fit, claiming all slots with a single CAS.
+     *  @return Count of pushed elements, they are always a prefix of [first, last).
+    */
+    template<typename It>
+    inline size_t TryPushBatch(It first, It last) {
+        const auto wanted = static_cast<size_t>(std::distance(first, last));
+        if (wanted == 0) {
+            return 0;
+        }
+        auto [position, count] = Claim(enqueue_pos_, 0, wanted);
+        for (size_t i = 0; i < count; ++i, ++first) {
+            cell_type& cell = cells_[GetIndex(position + i)];
+            try {
+                new(cell.storage) T(*first);
+            } catch (...) {
+                Skip(position + i, count - i);
+                throw;
+            }
+            cell.sequence.store(position + i + 1, std::memory_order_release);
+        }
+        return count;
+    }
+
+    /**
+     *  @brief Pop up to "max_count" front elements to "out", claiming all slots with a single CAS.
+     *  Skipped slots are released without output, slots are claimed again while all claimed ones were skipped.
+     *  @return Count of popped elements.
+    */
+    template<typename OutIt>
+    inline size_t TryPopBatch(OutIt out, size_t max_count) {
+        if (max_count == 0) {
+            return 0;
+        }
+        size_t popped = 0;
+        while (popped == 0) {
+            auto [position, count] = Claim(dequeue_pos_, 1, max_count);
+            if (count == 0) {
+                break;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                cell_type& cell = cells_[GetIndex(position + i)];
+                if (cell.skipped) {
+                    cell.skipped = false;
+                } else {
+                    T* element = cell.Get();
+                    *out = std::move(*element);
+                    ++out;
+                    ++popped;
+                    element->~T();
+                }
+                cell.sequence.store(position + i + _Capacity, std::memory_order_release);
+            }
+        }
+        return popped;
+    }
+
+    /**
+     *  @brief Returns approximate count of elements in the container.
+    */
+    inline size_t Size() const {
+        const size_t dequeue = dequeue_pos_.load(std::memory_order_acquire);
+        const size_t enqueue = enqueue_pos_.load(std::memory_order_acquire);
+        const auto size = Difference(enqueue, dequeue);
+        return size < 0 ? 0 : std::min(static_cast<size_t>(size), _Capacity);
+    }
+
+    /**
+     *  @brief Returns Capacity of the container.
+    */
+    inline size_t Capacity() const {
+        return _Capacity;
+    }
+
+    /**
+     *  @brief Returns true if the container is empty.
+    */
+    inline bool IsEmpty() const {
+        return Size() == 0;
+    }
+
+    /**
+     *  @brief Returns true if the container is full.
+    */
+    inline bool IsFull() const {
+        return Size() == _Capacity;
+    }
+};
+
+}
+
+/**
+ *  @brief Multi-producer/multi-consumer Circular Buffer Array
+ *  Allocate data in heap
+ *  @tparam T Type
+ *  @tparam Capacity Container max Size
+ *  @tparam IsHeap If "int", it is allocated in the heap regardless of Size.
+ *  If a standard allocator, storage is allocated with it regardless of Size.
+ *  If AlignedHeap, it is allocated in the heap with the given alignment.
+ *  @tparam PaddedSlots If true, every slot is stored on its own cache line.
+*/
+template<typename T, std::size_t _Capacity, typename IsHeap = bool, bool _PaddedSlots = false>
+class MpmcCircularBufferArray
+    : public MpmcCircularBufferArrayBase<T, _Capacity, HeapStorageT<MpmcCell<T, _PaddedSlots>, _Capacity, IsHeap>, _PaddedSlots> {
+public:
+    static_assert(_Capacity != 0, "_Capacity must be greater than 0");
+
+    using Super = MpmcCircularBufferArrayBase<T, _Capacity, HeapStorageT<MpmcCell<T, _PaddedSlots>, _Capacity, IsHeap>, _PaddedSlots>;
+    using Super::Super;
+};
+
+/**
+ *  @brief Multi-producer/multi-consumer Circular Buffer Array
+ *  Allocate data in stack
+ *  @tparam T Type
+ *  @tparam Capacity Container max Size
+ *  @tparam PaddedSlots If true, every slot is stored on its own cache line.
+*/
+template<typename T, std::size_t _Capacity, bool _PaddedSlots>
+class MpmcCircularBufferArray<T, _Capacity, std::enable_if_t<(0 < _Capacity && (_Capacity * sizeof(MpmcCell<T, _PaddedSlots>)) <= max_stack_size), bool>, _PaddedSlots>
+    : public MpmcCircularBufferArrayBase<T, _Capacity, StackAllocator<MpmcCell<T, _PaddedSlots>, _Capacity>, _PaddedSlots> {
+
+public:
+    using Super = MpmcCircularBufferArrayBase<T, _Capacity, StackAllocator<MpmcCell<T, _PaddedSlots>, _Capacity>, _PaddedSlots>;
+    using Super::Super;
+};
+
+
+/**
+ *  @brief Circular Buffer with capacity set at runtime
+ *  Allocate data through "Alloc" using std::allocator_traits.
+ *  Capacity can be changed with Reserve/Resize/ShrinkToFit, elements are relocated and straightened
+ *  into one contiguous block starting at index 0.
+ *  @tparam T Type
+ *  @tparam Alloc Standard allocator of T
+ *  @tparam OverflowPolicy OverwritePolicy, RejectPolicy or GrowPolicy
+*/
+template<typename T, typename Alloc = std::allocator<T>, typename OverflowPolicy = OverwritePolicy>
+class CircularBuffer {
+    static_assert(std::is_same_v<OverflowPolicy, OverwritePolicy> || std::is_same_v<OverflowPolicy, RejectPolicy>
+                  || std::is_same_v<OverflowPolicy, GrowPolicy>, "Unknown overflow policy");
+
+    using alloc_traits = std::allocator_traits<Alloc>;
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    Alloc allocator_;
+    T* buffer_ = nullptr;
+    size_t capacity_ = 0;
+    size_t start_ = 0;
+    size_t fullness_ = 0;
+
+    /**
+     *  @brief Returns the storage index of the n-th element counting from the front.
+    */
+    inline size_t GetIndex(size_t n) const {
+        size_t index = start_ + n;
+        return index < capacity_ ? index : index - capacity_;
+    }
+
+    void Destroy() {
+        while (fullness_ > 0) {
+            PopBack();
+        }
+    }
+
+    /**
+     *  @brief Erases the front element of a full container and constructs the new back element in its slot.
+     *  If the constructor throws the container stays valid without the erased element.
+    */
+    template<typename... Args>
+    inline pointer ReplaceFront(Args&& ... args) {
+        T* back_ptr = buffer_ + start_;
+        alloc_traits::destroy(allocator_, back_ptr);
+        start_ = GetIndex(1);
+        --fullness_;
+        alloc_traits::construct(allocator_, back_ptr, std::forward<Args>(args)...);
+        ++fullness_;
+        return back_ptr;
+    }
+
+    void Deallocate() {
+        if (buffer_ != nullptr) {
+            alloc_traits::deallocate(allocator_, buffer_, capacity_);
+            buffer_ = nullptr;
+        }
+        capacity_ = 0;
+        start_ = 0;
+    }
+
+    /**
+     *  @brief Move elements to a new storage of "new_capacity" in one pass over both contiguous segments.
+     *  Elements are moved when T is nothrow move constructible and copied otherwise, so an exception
+     *  leaves the container unchanged.
+    */
+    void Relocate(size_t new_capacity) {
+        assert(fullness_ <= new_capacity && "new_capacity must be greater or equal to size.");
+        T* new_buffer = new_capacity > 0 ? alloc_traits::allocate(allocator_, new_capacity) : nullptr;
+        const size_t first_count = std::min(fullness_, capacity_ - start_);
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (fullness_ > 0) {
+                std::memcpy(new_buffer, buffer_ + start_, first_count * sizeof(T));
+                std::memcpy(new_buffer + first_count, buffer_, (fullness_ - first_count) * sizeof(T));
+            }
+        } else {
+            size_t constructed = 0;
+            try {
+                for (size_t i = start_; i < start_ + first_count; ++i, ++constructed) {
+                    alloc_traits::construct(allocator_, new_buffer + constructed, std::move_if_noexcept(buffer_[i]));
+                }
+                for (size_t i = 0; constructed < fullness_; ++i, ++constructed) {
+                    alloc_traits::construct(allocator_, new_buffer + constructed, std::move_if_noexcept(buffer_[i]));
+                }
+            } catch (...) {
+                for (size_t i = 0; i < constructed; ++i) {
+                    alloc_traits::destroy(allocator_, new_buffer + i);
+                }
+                alloc_traits::deallocate(allocator_, new_buffer, new_capacity);
+                throw;
+            }
+            for (size_t i = 0; i < fullness_; ++i) {
+                alloc_traits::destroy(allocator_, buffer_ + GetIndex(i));
+            }
+        }
+        const size_t fullness = fullness_;
+        Deallocate();
+        buffer_ = new_buffer;
+        capacity_ = new_capacity;
+        fullness_ = fullness;
+    }
+
+    /**
+     *  @brief Take over the storage of "other", this container must own no storage.
+    */
+    void StealStorage(CircularBuffer& other) noexcept {
+        buffer_ = other.buffer_;
+        capacity_ = other.capacity_;
+        start_ = other.start_;
+        fullness_ = other.fullness_;
+        other.buffer_ = nullptr;
+        other.capacity_ = 0;
+        other.start_ = 0;
+        other.fullness_ = 0;
+    }
+
+    /**
+     *  @brief Move elements of "other" one by one, used when allocators are not equal, this container must be empty.
+     *  Storage is relocated to "other"'s capacity first, so the ring overwrites at the same point.
+    */
+    void MoveElements(CircularBuffer& other) {
+        if (capacity_ != other.capacity_) {
+            Relocate(other.capacity_);
+        }
+        for (T& value : other) {
+            EmplaceBack(std::move(value));
+        }
+        other.Clear();
+    }
+
+    template<typename ValueType>
+    class const_iterator_base {
+        const CircularBuffer* container_ptr_;
+        size_t offset_ = 0;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ValueType;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        explicit const_iterator_base(const CircularBuffer* container, size_t offset = 0) noexcept
+            : container_ptr_(container), offset_(offset) {
+            assert(offset <= container->fullness_ && "Offset must be less than to the fullness.");
+        }
+
+        reference operator*() const noexcept {
+            return *(container_ptr_->buffer_ + container_ptr_->GetIndex(offset_));
+        }
+
+        pointer operator->() const noexcept {
+            return container_ptr_->buffer_ + container_ptr_->GetIndex(offset_);
+        }
+
+        const_iterator_base& operator++() noexcept {
+            ++offset_;
+            return *this;
+        }
+
+        const_iterator_base operator++(int) noexcept {
+            const_iterator_base Tmp = *this;
+            ++*this;
+            return Tmp;
+        }
+
+        bool operator==(const const_iterator_base& rhs) const {
+            return container_ptr_ == rhs.container_ptr_ && offset_ == rhs.offset_;
+        }
+
+        bool operator!=(const const_iterator_base& rhs) const {
+            return !(rhs == *this);
+        }
+    };
+
+    template<typename ValueType>
+    class iterator_base : public const_iterator_base<ValueType> {
+    public:
+        using Super = const_iterator_base<ValueType>;
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ValueType;
+        using difference_type = std::ptrdiff_t;
+        using pointer = value_type*;
+        using reference = value_type&;
+
+        using Super::Super;
+
+        reference operator*() const noexcept {
+            return const_cast<reference>(Super::operator*());
+        }
+
+        pointer operator->() const noexcept {
+            return &(const_cast<reference>(Super::operator*()));
+        }
+
+        iterator_base& operator++() noexcept {
+            Super::operator++();
+            return *this;
+        }
+
+        iterator_base operator++(int) noexcept {
+            iterator_base Tmp = *this;
+            Super::operator++();
+            return Tmp;
+        }
+    };
+
+public:
+
+    CircularBuffer() = default;
+
+    explicit CircularBuffer(const Alloc& allocator) : allocator_(allocator) {}
+
+    explicit CircularBuffer(size_t capacity, const Alloc& allocator = Alloc()) : allocator_(allocator) {
+        Reserve(capacity);
+    }
+
+    /**
+     *  @brief Creates a full buffer of "capacity" copies of "value".
+    */
+    CircularBuffer(size_t capacity, const T& value, const Alloc& allocator = Alloc())
+        : CircularBuffer(capacity, allocator) {
+        for (size_t i = 0; i < capacity; ++i) {
+            EmplaceBack(value);
+        }
+    }
+
+    /**
+     *  @brief Creates a buffer with capacity equal to the count of elements in [begin, end).
+    */
+    template<typename It, typename = typename std::iterator_traits<It>::iterator_category>
+    CircularBuffer(It begin, It end, const Alloc& allocator = Alloc())
+        : CircularBuffer(static_cast<size_t>(std::distance(begin, end)), allocator) {
+        for (It iter = begin; iter != end; ++iter) {
+            EmplaceBack(*iter);
+        }
+    }
+
+    CircularBuffer(const std::initializer_list<T>& initializer_list, const Alloc& allocator = Alloc())
+        : CircularBuffer(initializer_list.begin(), initializer_list.end(), allocator) {}
+
+    CircularBuffer(const CircularBuffer& other)
+        : CircularBuffer(other, alloc_traits::select_on_container_copy_construction(other.allocator_)) {}
+
+    CircularBuffer(const CircularBuffer& other, const Alloc& allocator)
+        : CircularBuffer(other.capacity_, allocator) {
+        for (const T& value : other) {
+            EmplaceBack(value);
+        }
+    }
+
+    CircularBuffer(CircularBuffer&& other) noexcept
+        : allocator_(std::move(other.allocator_)) {
+        StealStorage(other);
+    }
+
+    /**
+     *  @brief Move with a given allocator. Storage is taken over only if allocators are equal,
+     *  otherwise elements are moved one by one into storage from "allocator".
+    */
+    CircularBuffer(CircularBuffer&& other, const Alloc& allocator)
+        : allocator_(allocator) {
+        if (allocator_ == other.allocator_) {
+            StealStorage(other);
+        } else {
+            MoveElements(other);
+        }
+    }
+
+    CircularBuffer& operator=(const CircularBuffer& other) {
+        if (this == &other) return *this;
+        CircularBuffer temp(other, alloc_traits::propagate_on_container_copy_assignment::value
+                                   ? other.allocator_ : allocator_);
+        Destroy();
+        Deallocate();
+        if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+            allocator_ = other.allocator_;
+        }
+        StealStorage(temp);
+        return *this;
+    }
+
+    CircularBuffer& operator=(CircularBuffer&& other)
+        noexcept(alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value) {
+        if (this == &other) return *this;
+        Destroy();
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+            Deallocate();
+            allocator_ = std::move(other.allocator_);
+            StealStorage(other);
+        } else {
+            if (allocator_ == other.allocator_) {
+                Deallocate();
+                StealStorage(other);
+            } else {
+                MoveElements(other);
+            }
+        }
+        return *this;
+    }
+
+    ~CircularBuffer() {
+        Destroy();
+        Deallocate();
+    }
+
+    /**
+     *  @brief Swap contents. Allocators are swapped only if the allocator propagates on swap,
+     *  otherwise they must be equal.
+    */
+    void Swap(CircularBuffer& other) noexcept {
+        using std::swap;
+        if constexpr (alloc_traits::propagate_on_container_swap::value) {
+            swap(allocator_, other.allocator_);
+        } else {
+            assert(allocator_ == other.allocator_ && "Allocators must be equal");
+        }
+        swap(buffer_, other.buffer_);
+        swap(capacity_, other.capacity_);
+        swap(start_, other.start_);
+        swap(fullness_, other.fullness_);
+    }
+
+    /**
+     *  @brief Returns a copy of the allocator associated with the container.
+    */
+    allocator_type GetAllocator() const {
+        return allocator_;
+    }
+
+    /**
+     *  @brief Emplace element at the back of the container
+     *  If the container is full the front element is overwritten, with RejectPolicy nothing is pushed,
+     *  with GrowPolicy the capacity is doubled. If the constructor throws the container is unchanged.
+     *  @return T*  A pointer to the construct element, nullptr if the container is full with RejectPolicy.
+    */
+    template<typename... Args>
+    inline pointer EmplaceBack(Args&& ... args) {
+        if (fullness_ == capacity_) {
+            if constexpr (std::is_same_v<OverflowPolicy, RejectPolicy>) {
+                return nullptr;
+            } else if constexpr (std::is_same_v<OverflowPolicy, GrowPolicy>) {
+                // Arguments may refer to elements of this container, build the element before relocation
+                T value(std::forward<Args>(args)...);
+                Relocate(capacity_ > 0 ? capacity_ * 2 : 1);
+                T* back_ptr = buffer_ + fullness_;
+                alloc_traits::construct(allocator_, back_ptr, std::move(value));
+                ++fullness_;
+                return back_ptr;
+            } else {
+                assert(0 < capacity_ && "Capacity must be greater than 0");
+                if constexpr (std::is_trivially_destructible_v<T> && std::is_nothrow_constructible_v<T, Args&& ...>) {
+                    return ReplaceFront(std::forward<Args>(args)...);
+                } else {
+                    // Arguments may throw or refer to the overwritten front element, build the element before it is erased
+                    T value(std::forward<Args>(args)...);
+                    return ReplaceFront(std::move(value));
+                }
+            }
+        }
+        T* back_ptr = buffer_ + GetIndex(fullness_);
+        alloc_traits::construct(allocator_, back_ptr, std::forward<Args>(args)...);
+        ++fullness_;
+        return back_ptr;
+    }
+
+    /**
+     *  @brief Push element at the back of the container
+     *  @return T*  A pointer to the copied element.
+    */
+    template<typename U = T>
+    inline pointer PushBack(U&& value) {
+        return EmplaceBack(std::forward<U>(value));
+    }
+
+    /**
+     *  @brief Erase first element in container
+     *  A destructor will be called for the erased element.
+    */
+    inline void PopFront() {
+        assert(0 < fullness_ && "Fullness must be greater than 0");
+        alloc_traits::destroy(allocator_, buffer_ + start_);
+        start_ = GetIndex(1);
+        --fullness_;
+    }
+
+    /**
+     *  @brief Erase last element in container
+     *  A destructor will be called for the erased element.
+    */
+    inline void PopBack() {
+        assert(0 < fullness_ && "Fullness must be greater than 0");
+        alloc_traits::destroy(allocator_, buffer_ + GetIndex(fullness_ - 1));
+        --fullness_;
+    }
+
+    /**
+     *  @brief Returns a reference to the element at the front position in the container.
+    */
+    inline reference GetFront() {
+        assert(0 < fullness_ && "Fullness must be greater than 0");
+        return *(buffer_ + start_);
+    }
+
+    /**
+     *  @brief Returns a reference to the element at the back position in the container.
+    */
+    inline reference GetBack() {
+        assert(0 < fullness_ && "Fullness must be greater than 0");
+        return *(buffer_ + GetIndex(fullness_ - 1));
+    }
+
+    /**
+     *  @brief Returns the front element moved out of the container.
+     *  Element will be erased from the container
+     */
+    inline value_type ReleaseFront() {
+        value_type temp = std::move(GetFront());
+        PopFront();
+        return temp;
+    }
+
+    /**
+     *  @brief Returns the back element moved out of the container.
+     *  Element will be erased from the container
+     */
+    inline value_type ReleaseBack() {
+        value_type temp = std::move(GetBack());
+        PopBack();
+        return temp;
+    }
+
+    /**
+     *  @brief Returns count of elements in the container.
+    */
+    inline size_t Size() const {
+        return fullness_;
+    }
+
+    /**
+     *  @brief Returns Capacity of the container.
+    */
+    inline size_t Capacity() const {
+        return capacity_;
+    }
+
+    /**
+     *  @brief Erase all in the container. Capacity is not changed.
+    */
+    inline void Clear() {
+        Destroy();
+        start_ = 0;
+    }
+
+    /**
+     *  @brief Returns true if the container is IsEmpty.
+    */
+    inline bool IsEmpty() const {
+        return !fullness_;
+    }
+
+    /**
+     *  @brief Returns true if the container is full.
+    */
+    inline bool IsFull() const {
+        return fullness_ == capacity_;
+    }
+
+    /**
+     *  @brief Increase capacity to at least "new_capacity". Never shrinks.
+    */
+    void Reserve(size_t new_capacity) {
+        if (new_capacity > capacity_) {
+            Relocate(new_capacity);
+        }
+    }
+
+    /**
+     *  @brief Change count of elements to "new_size".
+     *  New elements are copies of "value" appended at the back, extra elements are erased from the back.
+     *  Capacity grows if "new_size" does not fit.
+    */
+    void Resize(size_t new_size, const T& value = T()) {
+        Reserve(new_size);
+        while (fullness_ > new_size) {
+            PopBack();
+        }
+        while (fullness_ < new_size) {
+            EmplaceBack(value);
+        }
+    }
+
+    /**
+     *  @brief Reduce capacity to the count of elements.
+    */
+    void ShrinkToFit() {
+        if (fullness_ < capacity_) {
+            Relocate(fullness_);
+        }
+    }
+
+    reference operator[](size_t n) {
+        assert(n < fullness_ && "n must be less than fullness.");
+        return *(buffer_ + GetIndex(n));
+    }
+
+    const_reference operator[](size_t n) const {
+        assert(n < fullness_ && "n must be less than fullness.");
+        return *(buffer_ + GetIndex(n));
+    }
+
+    using iterator = iterator_base<value_type>;
+    using const_iterator = const_iterator_base<value_type>;
+
+    /**
+     *  @brief Returns an iterator to the beginning of the container.
+     */
+    iterator begin() noexcept {
+        return iterator(this);
+    }
+
+    /**
+     *  @brief Returns an iterator to the end of the container.
+     */
+    iterator end() noexcept {
+        return iterator(this, fullness_);
+    }
+
+    /**
+     *  @brief Returns a const iterator to the beginning of the container.
+     */
+    const_iterator cbegin() const noexcept {
+        return const_iterator(this);
+    }
+
+    /**
+     *  @brief Returns a const iterator to the end of the container.
+     */
+    const_iterator cend() const noexcept {
+        return const_iterator(this, fullness_);
+    }
+
+    /**
+     *  @brief Returns a const iterator to the beginning of the container.
+     */
+    const_iterator begin() const noexcept {
+        return cbegin();
+    }
+
+    /**
+     *  @brief Returns a const iterator to the end of the container.
+     */
+    const_iterator end() const noexcept {
+        return cend();
+    }
+};
+
+namespace {
+
+/**
+ *  @brief Hint to the CPU that the thread is spinning.
+*/
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+}
+
+/**
+ *  @brief Blocking producer/consumer Circular Buffer Array
+ *  Push waits while the container is full, Pop waits while it is empty, nothing is overwritten.
+ *  A waiting thread first spins on an atomic size for an adaptive number of iterations, then sleeps on a
+ *  condition variable. Sleeping consumers are woken once "wakeup_batch" elements are ready, not on every push,
+ *  and pick up a partial batch after at most "max_wakeup_delay". Producers are woken the same way on free space.
+ *  Storage is a CircularBufferArray with the same IsHeap selection.
+ *  @tparam T Type
+ *  @tparam Capacity Container max Size
+ *  @tparam IsHeap If "int", it is allocated in the heap regardless of Size.
+ *  If a standard allocator, storage is allocated with it regardless of Size.
+*/
+template<typename T, std::size_t _Capacity, typename IsHeap = bool>
+class BlockingCircularBufferArray {
+    static constexpr size_t min_spin_count = 16;
+    static constexpr size_t max_spin_count = 4096;
+
+    using clock = std::chrono::steady_clock;
+
+    CircularBufferArray<T, _Capacity, IsHeap> buffer_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    size_t consumers_waiting_ = 0;
+    size_t producers_waiting_ = 0;
+    bool closed_ = false;
+
+    const size_t wakeup_batch_;
+    const std::chrono::microseconds max_wakeup_delay_;
+
+    // Read without the lock by spinning threads
+    alignas(cache_line_size) std::atomic<size_t> size_{0};
+    std::atomic<size_t> spin_count_{min_spin_count};
+
+    /**
+     *  @brief Spin until "is_ready" returns true or the spin budget is exhausted.
+     *  The budget doubles after a successful spin and halves after a failed one.
+    */
+    template<typename Predicate>
+    bool Spin(Predicate is_ready) {
+        const size_t spin_count = spin_count_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < spin_count; ++i) {
+            if (is_ready()) {
+                spin_count_.store(std::min(spin_count * 2, max_spin_count), std::memory_order_relaxed);
+                return true;
+            }
+            CpuRelax();
+        }
+        spin_count_.store(std::max(spin_count / 2, min_spin_count), std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     *  @brief Wait on "condition" until "is_ready" returns true, the container is closed or "deadline" passes.
+     *  With batched wakeups the sleep is sliced by max_wakeup_delay, so a partial batch is not left waiting.
+     *  @return false if the deadline passed.
+    */
+    template<typename Predicate>
+    bool Wait(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, size_t& waiting,
+              clock::time_point deadline, Predicate is_ready) {
+        while (!is_ready() && !closed_) {
+            clock::time_point wake_time = deadline;
+            if (wakeup_batch_ > 1) {
+                wake_time = std::min(deadline, clock::now() + max_wakeup_delay_);
+            }
+            ++waiting;
+            condition.wait_until(lock, wake_time);
+            --waiting;
+            if (clock::now() >= deadline && !is_ready()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void NotifyConsumers(std::unique_lock<std::mutex>& lock) {
+        const bool notify = consumers_waiting_ > 0 && buffer_.Size() >= std::min(wakeup_batch_, _Capacity);
+        lock.unlock();
+        if (notify) {
+            not_empty_.notify_one();
+        }
+    }
+
+    void NotifyProducers(std::unique_lock<std::mutex>& lock) {
+        const bool notify = producers_waiting_ > 0 && _Capacity - buffer_.Size() >= std::min(wakeup_batch_, _Capacity);
+        lock.unlock();
+        if (notify) {
+            not_full_.notify_one();
+        }
+    }
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    /**
+     *  @param wakeup_batch Count of ready elements (or free slots) that wakes a sleeping consumer (or producer).
+     *  @param max_wakeup_delay Longest time a sleeping thread ignores a partial batch.
+    */
+    explicit BlockingCircularBufferArray(size_t wakeup_batch = 1,
+                                         std::chrono::microseconds max_wakeup_delay = std::chrono::microseconds(100))
+        : wakeup_batch_(std::max<size_t>(wakeup_batch, 1)), max_wakeup_delay_(max_wakeup_delay) {}
+
+    BlockingCircularBufferArray(const BlockingCircularBufferArray&) = delete;
+    BlockingCircularBufferArray& operator=(const BlockingCircularBufferArray&) = delete;
+
+    /**
+     *  @brief Push element at the back of the container, waiting up to "timeout" for free space.
+     *  @return false on timeout or if the container is closed.
+    */
+    template<typename U, typename Rep, typename Period>
+    bool Push(U&& value, const std::chrono::duration<Rep, Period>& timeout) {
+        const clock::time_point deadline = clock::now() + timeout;
+        Spin([this]() { return size_.load(std::memory_order_relaxed) < _Capacity; });
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!Wait(lock, not_full_, producers_waiting_, deadline, [this]() { return !buffer_.IsFull(); }) || closed_) {
+            return false;
+        }
+        buffer_.PushBack(std::forward<U>(value));
+        size_.store(buffer_.Size(), std::memory_order_relaxed);
+        NotifyConsumers(lock);
+        return true;
+    }
+
+    /**
+     *  @brief Push element at the back of the container, waiting for free space as long as needed.
+     *  @return false if the container is closed.
+    */
+    template<typename U>
+    bool Push(U&& value) {
+        return Push(std::forward<U>(value), clock::duration::max() / 2);
+    }
+
+    /**
+     *  @brief Push element at the back of the container if there is free space.
+    */
+    template<typename U>
+    bool TryPush(U&& value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (closed_ || buffer_.IsFull()) {
+            return false;
+        }
+        buffer_.PushBack(std::forward<U>(value));
+        size_.store(buffer_.Size(), std::memory_order_relaxed);
+        NotifyConsumers(lock);
+        return true;
+    }
+
+    /**
+     *  @brief Move up to "max_count" front elements to "out", waiting up to "timeout" for at least one.
+     *  @return Count of moved elements, 0 on timeout or if the container is closed and empty.
+    */
+    template<typename OutIt, typename Rep, typename Period>
+    size_t PopBatch(OutIt out, size_t max_count, const std::chrono::duration<Rep, Period>& timeout) {
+        const clock::time_point deadline = clock::now() + timeout;
+        Spin([this]() { return size_.load(std::memory_order_relaxed) > 0; });
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!Wait(lock, not_empty_, consumers_waiting_, deadline, [this]() { return !buffer_.IsEmpty(); })) {
+            return 0;
+        }
+        const size_t count = buffer_.PopFrontInto(out, max_count);
+        size_.store(buffer_.Size(), std::memory_order_relaxed);
+        NotifyProducers(lock);
+        return count;
+    }
+
+    /**
+     *  @brief Move the front element to "value", waiting up to "timeout" for it.
+     *  @return false on timeout or if the container is closed and empty.
+    */
+    template<typename Rep, typename Period>
+    bool Pop(T& value, const std::chrono::duration<Rep, Period>& timeout) {
+        return PopBatch(&value, 1, timeout) == 1;
+    }
+
+    /**
+     *  @brief Move the front element to "value", waiting for it as long as needed.
+     *  @return false if the container is closed and empty.
+    */
+    bool Pop(T& value) {
+        return Pop(value, clock::duration::max() / 2);
+    }
+
+    /**
+     *  @brief Move the front element to "value" if there is one.
+    */
+    bool TryPop(T& value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (buffer_.IsEmpty()) {
+            return false;
+        }
+        buffer_.PopFrontInto(&value, 1);
+        size_.store(buffer_.Size(), std::memory_order_relaxed);
+        NotifyProducers(lock);
+        return true;
+    }
+
+    /**
+     *  @brief Reject further pushes and wake all waiting threads. Remaining elements can still be popped.
+    */
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    /**
+     *  @brief Returns true if the container is closed.
+    */
+    bool IsClosed() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+    /**
+     *  @brief Returns count of elements in the container at the moment of the call.
+    */
+    inline size_t Size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     *  @brief Returns Capacity of the container.
+    */
+    inline size_t Capacity() const {
+        return _Capacity;
+    }
+
+    /**
+     *  @brief Returns true if the container is empty at the moment of the call.
+    */
+    inline bool IsEmpty() const {
+        return Size() == 0;
+    }
+
+    /**
+     *  @brief Returns true if the container is full at the moment of the call.
+    */
+    inline bool IsFull() const {
+        return Size() == _Capacity;
+    }
+};
+
+/**
+ *  @brief Circular buffers allocating storage from a std::pmr::memory_resource.
+ *  Construct fixed capacity containers with (std::allocator_arg, resource) and CircularBuffer with (capacity, resource).
+*/
+namespace pmr {
+template<typename T, std::size_t _Capacity, typename OverflowPolicy = OverwritePolicy>
+using CircularBufferArray = ::CircularBufferArray<T, _Capacity, std::pmr::polymorphic_allocator<T>, OverflowPolicy>;
+
+template<typename T, std::size_t _Capacity>
+using SpscCircularBufferArray = ::SpscCircularBufferArray<T, _Capacity, std::pmr::polymorphic_allocator<T>>;
+
+template<typename T, std::size_t _Capacity>
+using MpmcCircularBufferArray = ::MpmcCircularBufferArray<T, _Capacity, std::pmr::polymorphic_allocator<T>>;
+
+template<typename T, typename OverflowPolicy = OverwritePolicy>
+using CircularBuffer = ::CircularBuffer<T, std::pmr::polymorphic_allocator<T>, OverflowPolicy>;
+}
@@ -0,0 +1,706 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CIRCULAR_BUFFER_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#include "CircularBuffer.h"
+
+/**
+ *  @brief Vectorized reductions over the contents of CircularBufferArray
+ *  Kernels run on the two contiguous segments of the ring (ArrayOne/ArrayTwo) and are selected at runtime:
+ *  AVX2 when the CPU supports it, SSE2 on other x86 CPUs and a scalar loop elsewhere.
+ *  Supported element types are int32_t, float and double. Sums and dot products of int32_t are accumulated
+ *  in 64 bits, of float and double in the element type, so floating point results differ from a sequential
+ *  loop by rounding only.
+*/
+namespace simd {
+
+enum class Level {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+/**
+ *  @brief Returns the best instruction set supported by the CPU.
+*/
+inline Level DetectLevel() {
+#ifdef CIRCULAR_BUFFER_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Level::Avx2;
+    if (__builtin_cpu_supports("sse2")) return Level::Sse2;
+#endif
+    return Level::Scalar;
+}
+
+/**
+ *  @brief Returns the instruction set used by default, detected once.
+*/
+inline Level GetLevel() {
+    static const Level level = DetectLevel();
+    return level;
+}
+
+template<typename T>
+using sum_type = std::conditional_t<std::is_integral_v<T>, long long, T>;
+
+namespace {
+
+template<typename T>
+struct ScalarKernels {
+    static sum_type<T> Sum(const T* data, size_t count) {
+        sum_type<T> sum = 0;
+        for (size_t i = 0; i < count; ++i) {
+            sum += data[i];
+        }
+        return sum;
+    }
+
+    static sum_type<T> Dot(const T* left, const T* right, size_t count) {
+        sum_type<T> sum = 0;
+        for (size_t i = 0; i < count; ++i) {
+            sum += static_cast<sum_type<T>>(left[i]) * right[i];
+        }
+        return sum;
+    }
+
+    static T Min(const T* data, size_t count) {
+        return *std::min_element(data, data + count);
+    }
+
+    static T Max(const T* data, size_t count) {
+        return *std::max_element(data, data + count);
+    }
+
+    static std::pair<T, T> MinMax(const T* data, size_t count) {
+        T min = data[0];
+        T max = data[0];
+        for (size_t i = 1; i < count; ++i) {
+            min = std::min(min, data[i]);
+            max = std::max(max, data[i]);
+        }
+        return {min, max};
+    }
+
+    static size_t CountGreater(const T* data, size_t count, T threshold) {
+        size_t result = 0;
+        for (size_t i = 0; i < count; ++i) {
+            result += data[i] > threshold;
+        }
+        return result;
+    }
+};
+
+// Instruction set kernels fall back to the scalar ones for types they do not specialize.
+template<typename T>
+struct Sse2Kernels : ScalarKernels<T> {};
+
+template<typename T>
+struct Avx2Kernels : ScalarKernels<T> {};
+
+#ifdef CIRCULAR_BUFFER_SIMD_X86
+
+template<>
+struct Sse2Kernels<float> {
+    static float Sum(const float* data, size_t count) {
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            sum0 = _mm_add_ps(sum0, _mm_loadu_ps(data + i));
+            sum1 = _mm_add_ps(sum1, _mm_loadu_ps(data + i + 4));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, _mm_add_ps(sum0, sum1));
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + ScalarKernels<float>::Sum(data + i, count - i);
+    }
+
+    static float Dot(const float* left, const float* right, size_t count) {
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(left + i), _mm_loadu_ps(right + i)));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(left + i + 4), _mm_loadu_ps(right + i + 4)));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, _mm_add_ps(sum0, sum1));
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3])
+               + ScalarKernels<float>::Dot(left + i, right + i, count - i);
+    }
+
+    static float Min(const float* data, size_t count) {
+        if (count < 4) return ScalarKernels<float>::Min(data, count);
+        __m128 result = _mm_loadu_ps(data);
+        size_t i = 4;
+        for (; i + 4 <= count; i += 4) {
+            result = _mm_min_ps(result, _mm_loadu_ps(data + i));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, result);
+        float min = *std::min_element(lanes, lanes + 4);
+        return i == count ? min : std::min(min, ScalarKernels<float>::Min(data + i, count - i));
+    }
+
+    static float Max(const float* data, size_t count) {
+        if (count < 4) return ScalarKernels<float>::Max(data, count);
+        __m128 result = _mm_loadu_ps(data);
+        size_t i = 4;
+        for (; i + 4 <= count; i += 4) {
+            result = _mm_max_ps(result, _mm_loadu_ps(data + i));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, result);
+        float max = *std::max_element(lanes, lanes + 4);
+        return i == count ? max : std::max(max, ScalarKernels<float>::Max(data + i, count - i));
+    }
+
+    static size_t CountGreater(const float* data, size_t count, float threshold) {
+        const __m128 limit = _mm_set1_ps(threshold);
+        size_t result = 0;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            result += __builtin_popcount(_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(data + i), limit)));
+        }
+        return result + ScalarKernels<float>::CountGreater(data + i, count - i, threshold);
+    }
+};
+
+template<>
+struct Sse2Kernels<double> {
+    static double Sum(const double* data, size_t count) {
+        __m128d sum0 = _mm_setzero_pd();
+        __m128d sum1 = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            sum0 = _mm_add_pd(sum0, _mm_loadu_pd(data + i));
+            sum1 = _mm_add_pd(sum1, _mm_loadu_pd(data + i + 2));
+        }
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, _mm_add_pd(sum0, sum1));
+        return lanes[0] + lanes[1] + ScalarKernels<double>::Sum(data + i, count - i);
+    }
+
+    static double Dot(const double* left, const double* right, size_t count) {
+        __m128d sum0 = _mm_setzero_pd();
+        __m128d sum1 = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            sum0 = _mm_add_pd(sum0, _mm_mul_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+            sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(left + i + 2), _mm_loadu_pd(right + i + 2)));
+        }
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, _mm_add_pd(sum0, sum1));
+        return lanes[0] + lanes[1] + ScalarKernels<double>::Dot(left + i, right + i, count - i);
+    }
+
+    static double Min(const double* data, size_t count) {
+        if (count < 2) return ScalarKernels<double>::Min(data, count);
+        __m128d result = _mm_loadu_pd(data);
+        size_t i = 2;
+        for (; i + 2 <= count; i += 2) {
+            result = _mm_min_pd(result, _mm_loadu_pd(data + i));
+        }
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, result);
+        double min = std::min(lanes[0], lanes[1]);
+        return i == count ? min : std::min(min, data[i]);
+    }
+
+    static double Max(const double* data, size_t count) {
+        if (count < 2) return ScalarKernels<double>::Max(data, count);
+        __m128d result = _mm_loadu_pd(data);
+        size_t i = 2;
+        for (; i + 2 <= count; i += 2) {
+            result = _mm_max_pd(result, _mm_loadu_pd(data + i));
+        }
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, result);
+        double max = std::max(lanes[0], lanes[1]);
+        return i == count ? max : std::max(max, data[i]);
+    }
+
+    static size_t CountGreater(const double* data, size_t count, double threshold) {
+        const __m128d limit = _mm_set1_pd(threshold);
+        size_t result = 0;
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2) {
+            result += __builtin_popcount(_mm_movemask_pd(_mm_cmpgt_pd(_mm_loadu_pd(data + i), limit)));
+        }
+        return result + ScalarKernels<double>::CountGreater(data + i, count - i, threshold);
+    }
+};
+
+// SSE2 has no 32-bit min/max and no signed 32x32->64 multiply, those are emulated or left to the scalar loop.
+template<>
+struct Sse2Kernels<int32_t> {
+    static long long Sum(const int32_t* data, size_t count) {
+        __m128i sum = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i sign = _mm_srai_epi32(values, 31);
+            sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(values, sign));
+            sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(values, sign));
+        }
+        alignas(16) long long lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sum);
+        return lanes[0] + lanes[1] + ScalarKernels<int32_t>::Sum(data + i, count - i);
+    }
+
+    static long long Dot(const int32_t* left, const int32_t* right, size_t count) {
+        return ScalarKernels<int32_t>::Dot(left, right, count);
+    }
+
+    static int32_t Min(const int32_t* data, size_t count) {
+        if (count < 4) return ScalarKernels<int32_t>::Min(data, count);
+        __m128i result = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        size_t i = 4;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i greater = _mm_cmpgt_epi32(result, values);
+            result = _mm_or_si128(_mm_and_si128(greater, values), _mm_andnot_si128(greater, result));
+        }
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), result);
+        int32_t min = *std::min_element(lanes, lanes + 4);
+        return i == count ? min : std::min(min, ScalarKernels<int32_t>::Min(data + i, count - i));
+    }
+
+    static int32_t Max(const int32_t* data, size_t count) {
+        if (count < 4) return ScalarKernels<int32_t>::Max(data, count);
+        __m128i result = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        size_t i = 4;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i greater = _mm_cmpgt_epi32(values, result);
+            result = _mm_or_si128(_mm_and_si128(greater, values), _mm_andnot_si128(greater, result));
+        }
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), result);
+        int32_t max = *std::max_element(lanes, lanes + 4);
+        return i == count ? max : std::max(max, ScalarKernels<int32_t>::Max(data + i, count - i));
+    }
+
+    static std::pair<int32_t, int32_t> MinMax(const int32_t* data, size_t count) {
+        if (count < 4) return ScalarKernels<int32_t>::MinMax(data, count);
+        __m128i min = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        __m128i max = min;
+        size_t i = 4;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i less = _mm_cmpgt_epi32(min, values);
+            const __m128i greater = _mm_cmpgt_epi32(values, max);
+            min = _mm_or_si128(_mm_and_si128(less, values), _mm_andnot_si128(less, min));
+            max = _mm_or_si128(_mm_and_si128(greater, values), _mm_andnot_si128(greater, max));
+        }
+        alignas(16) int32_t min_lanes[4];
+        alignas(16) int32_t max_lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(min_lanes), min);
+        _mm_store_si128(reinterpret_cast<__m128i*>(max_lanes), max);
+        std::pair<int32_t, int32_t> result(*std::min_element(min_lanes, min_lanes + 4),
+                                           *std::max_element(max_lanes, max_lanes + 4));
+        if (i != count) {
+            const auto tail = ScalarKernels<int32_t>::MinMax(data + i, count - i);
+            result = {std::min(result.first, tail.first), std::max(result.second, tail.second)};
+        }
+        return result;
+    }
+
+    static size_t CountGreater(const int32_t* data, size_t count, int32_t threshold) {
+        const __m128i limit = _mm_set1_epi32(threshold);
+        size_t result = 0;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            result += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(values, limit))));
+        }
+        return result + ScalarKernels<int32_t>::CountGreater(data + i, count - i, threshold);
+    }
+};
+
+#define CIRCULAR_BUFFER_AVX2 __attribute__((target("avx2")))
+
+template<>
+struct Avx2Kernels<float> {
+    CIRCULAR_BUFFER_AVX2 static float Horizontal(__m256 values) {
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, values);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+
+    CIRCULAR_BUFFER_AVX2 static float Sum(const float* data, size_t count) {
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            sum0 = _mm256_add_ps(sum0, _mm256_loadu_ps(data + i));
+            sum1 = _mm256_add_ps(sum1, _mm256_loadu_ps(data + i + 8));
+        }
+        return Horizontal(_mm256_add_ps(sum0, sum1)) + Sse2Kernels<float>::Sum(data + i, count - i);
+    }
+
+    CIRCULAR_BUFFER_AVX2 static float Dot(const float* left, const float* right, size_t count) {
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(right + i)));
+            sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_loadu_ps(left + i + 8), _mm256_loadu_ps(right + i + 8)));
+        }
+        return Horizontal(_mm256_add_ps(sum0, sum1)) + Sse2Kernels<float>::Dot(left + i, right + i, count - i);
+    }
+
+    CIRCULAR_BUFFER_AVX2 static float Min(const float* data, size_t count) {
+        if (count < 8) return ScalarKernels<float>::Min(data, count);
+        __m256 result = _mm256_loadu_ps(data);
+        size_t i = 8;
+        for (; i + 8 <= count; i += 8) {
+            result = _mm256_min_ps(result, _mm256_loadu_ps(data + i));
+        }
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, result);
+        float min = *std::min_element(lanes, lanes + 8);
+        return i == count ? min : std::min(min, ScalarKernels<float>::Min(data + i, count - i));
+    }
+
+    CIRCULAR_BUFFER_AVX2 static float Max(const float* data, size_t count) {
+        if (count < 8) return ScalarKernels<float>::Max(data, count);
+        __m256 result = _mm256_loadu_ps(data);
+        size_t i = 8;
+        for (; i + 8 <= count; i += 8) {
+            result = _mm256_max_ps(result, _mm256_loadu_ps(data + i));
+        }
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, result);
+        float max = *std::max_element(lanes, lanes + 8);
+        return i == count ? max : std::max(max, ScalarKernels<float>::Max(data + i, count - i));
+    }
+
+    CIRCULAR_BUFFER_AVX2 static size_t CountGreater(const float* data, size_t count, float threshold) {
+        const __m256 limit = _mm256_set1_ps(threshold);
+        size_t result = 0;
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            result += __builtin_popcount(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + i), limit, _CMP_GT_OQ)));
+        }
+        return result + ScalarKernels<float>::CountGreater(data + i, count - i, threshold);
+    }
+};
+
+template<>
+struct Avx2Kernels<double> {
+    CIRCULAR_BUFFER_AVX2 static double Horizontal(__m256d values) {
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, values);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    CIRCULAR_BUFFER_AVX2 static double Sum(const double* data, size_t count) {
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            sum0 = _mm256_add_pd(sum0, _mm256_loadu_pd(data + i));
+            sum1 = _mm256_add_pd(sum1, _mm256_loadu_pd(data + i + 4));
+        }
+        return Horizontal(_mm256_add_pd(sum0, sum1)) + Sse2Kernels<double>::Sum(data + i, count - i);
+    }
+
+    CIRCULAR_BUFFER_AVX2 static double Dot(const double* left, const double* right, size_t count) {
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i)));
+            sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(_mm256_loadu_pd(left + i + 4), _mm256_loadu_pd(right + i + 4)));
+        }
+        return Horizontal(_mm256_add_pd(sum0, sum1)) + Sse2Kernels<double>::Dot(left + i, right + i, count - i);
+    }
+
+    CIRCULAR_BUFFER_AVX2 static double Min(const double* data, size_t count) {
+        if (count < 4) return ScalarKernels<double>::Min(data, count);
+        __m256d result = _mm256_loadu_pd(data);
+        size_t i = 4;
+        for (; i + 4 <= count; i += 4) {
+            result = _mm256_min_pd(result, _mm256_loadu_pd(data + i));
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, result);
+        double min = *std::min_element(lanes, lanes + 4);
+        return i == count ? min : std::min(min, ScalarKernels<double>::Min(data + i, count - i));
+    }
+
+    CIRCULAR_BUFFER_AVX2 static double Max(const double* data, size_t count) {
+        if (count < 4) return ScalarKernels<double>::Max(data, count);
+        __m256d result = _mm256_loadu_pd(data);
+        size_t i = 4;
+        for (; i + 4 <= count; i += 4) {
+            result = _mm256_max_pd(result, _mm256_loadu_pd(data + i));
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, result);
+        double max = *std::max_element(lanes, lanes + 4);
+        return i == count ? max : std::max(max, ScalarKernels<double>::Max(data + i, count - i));
+    }
+
+    CIRCULAR_BUFFER_AVX2 static size_t CountGreater(const double* data, size_t count, double threshold) {
+        const __m256d limit = _mm256_set1_pd(threshold);
+        size_t result = 0;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            result += __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + i), limit, _CMP_GT_OQ)));
+        }
+        return result + ScalarKernels<double>::CountGreater(data + i, count - i, threshold);
+    }
+};
+
+template<>
+struct Avx2Kernels<int32_t> {
+    CIRCULAR_BUFFER_AVX2 static long long Horizontal(__m256i values) {
+        alignas(32) long long lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), values);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    CIRCULAR_BUFFER_AVX2 static long long Sum(const int32_t* data, size_t count) {
+        __m256i sum0 = _mm256_setzero_si256();
+        __m256i sum1 = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            sum0 = _mm256_add_epi64(sum0, _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))));
+            sum1 = _mm256_add_epi64(sum1, _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 4))));
+        }
+        return Horizontal(_mm256_add_epi64(sum0, sum1)) + ScalarKernels<int32_t>::Sum(data + i, count - i);
+    }
+
+    CIRCULAR_BUFFER_AVX2 static long long Dot(const int32_t* left, const int32_t* right, size_t count) {
+        __m256i sum = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i));
+            // Signed 32x32->64 products of the even lanes, then of the odd lanes shifted down
+            sum = _mm256_add_epi64(sum, _mm256_mul_epi32(a, b));
+            sum = _mm256_add_epi64(sum, _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)));
+        }
+        return Horizontal(sum) + ScalarKernels<int32_t>::Dot(left + i, right + i, count - i);
+    }
+
+    CIRCULAR_BUFFER_AVX2 static int32_t Min(const int32_t* data, size_t count) {
+        if (count < 8) return ScalarKernels<int32_t>::Min(data, count);
+        __m256i result = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        size_t i = 8;
+        for (; i + 8 <= count; i += 8) {
+            result = _mm256_min_epi32(result, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+        }
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), result);
+        int32_t min = *std::min_element(lanes, lanes + 8);
+        return i == count ? min : std::min(min, ScalarKernels<int32_t>::Min(data + i, count - i));
+    }
+
+    CIRCULAR_BUFFER_AVX2 static int32_t Max(const int32_t* data, size_t count) {
+        if (count < 8) return ScalarKernels<int32_t>::Max(data, count);
+        __m256i result = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        size_t i = 8;
+        for (; i + 8 <= count; i += 8) {
+            result = _mm256_max_epi32(result, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+        }
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), result);
+        int32_t max = *std::max_element(lanes, lanes + 8);
+        return i == count ? max : std::max(max, ScalarKernels<int32_t>::Max(data + i, count - i));
+    }
+
+    CIRCULAR_BUFFER_AVX2 static std::pair<int32_t, int32_t> MinMax(const int32_t* data, size_t count) {
+        if (count < 8) return ScalarKernels<int32_t>::MinMax(data, count);
+        __m256i min = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        __m256i max = min;
+        size_t i = 8;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            min = _mm256_min_epi32(min, values);
+            max = _mm256_max_epi32(max, values);
+        }
+        alignas(32) int32_t min_lanes[8];
+        alignas(32) int32_t max_lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(min_lanes), min);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(max_lanes), max);
+        std::pair<int32_t, int32_t> result(*std::min_element(min_lanes, min_lanes + 8),
+                                           *std::max_element(max_lanes, max_lanes + 8));
+        if (i != count) {
+            const auto tail = ScalarKernels<int32_t>::MinMax(data + i, count - i);
+            result = {std::min(result.first, tail.first), std::max(result.second, tail.second)};
+        }
+        return result;
+    }
+
+    CIRCULAR_BUFFER_AVX2 static size_t CountGreater(const int32_t* data, size_t count, int32_t threshold) {
+        const __m256i limit = _mm256_set1_epi32(threshold);
+        size_t result = 0;
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            result += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(values, limit))));
+        }
+        return result + ScalarKernels<int32_t>::CountGreater(data + i, count - i, threshold);
+    }
+};
+
+#undef CIRCULAR_BUFFER_AVX2
+
+#endif
+
+/**
+ *  @brief Calls "func" with the kernels of "level" for T, "level" is lowered to the one supported by the CPU.
+*/
+template<typename T, typename Func>
+inline decltype(auto) Dispatch(Level level, Func&& func) {
+    static_assert(std::is_same_v<T, int32_t> || std::is_same_v<T, float> || std::is_same_v<T, double>,
+                  "Supported element types are int32_t, float and double");
+    switch (std::min(level, GetLevel())) {
+        case Level::Avx2:
+            return func(Avx2Kernels<T>());
+        case Level::Sse2:
+            return func(Sse2Kernels<T>());
+        default:
+            return func(ScalarKernels<T>());
+    }
+}
+
+/**
+ *  @brief Calls "func(left, right, count)" for each pair of contiguous pieces of two equally sized rings.
+ *  Segment boundaries of the two rings differ, so there are at most three pieces.
+*/
+template<typename Buffer, typename Func>
+inline void ForEachSegmentPair(const Buffer& left, const Buffer& right, Func&& func) {
+    assert(left.Size() == right.Size() && "Buffers must have equal size");
+    const auto left_segments = {left.ArrayOne(), left.ArrayTwo()};
+    const auto right_segments = {right.ArrayOne(), right.ArrayTwo()};
+    auto left_it = left_segments.begin();
+    auto right_it = right_segments.begin();
+    size_t left_offset = 0;
+    size_t right_offset = 0;
+    while (left_it != left_segments.end() && right_it != right_segments.end()) {
+        const size_t count = std::min(left_it->second - left_offset, right_it->second - right_offset);
+        if (count != 0) {
+            func(left_it->first + left_offset, right_it->first + right_offset, count);
+        }
+        left_offset += count;
+        right_offset += count;
+        if (left_offset == left_it->second) {
+            ++left_it;
+            left_offset = 0;
+        }
+        if (right_offset == right_it->second) {
+            ++right_it;
+            right_offset = 0;
+        }
+    }
+}
+
+}
+
+/**
+ *  @brief Returns sum of the elements.
+*/
+template<typename Buffer>
+inline sum_type<typename Buffer::value_type> Sum(const Buffer& buffer, Level level = GetLevel()) {
+    using T = typename Buffer::value_type;
+    return Dispatch<T>(level, [&buffer](auto kernels) {
+        sum_type<T> sum = 0;
+        buffer.ForEachSegment([&sum](const T* data, size_t count) {
+            sum += decltype(kernels)::Sum(data, count);
+        });
+        return sum;
+    });
+}
+
+/**
+ *  @brief Returns dot product of the elements of two buffers of equal size, element i with element i.
+*/
+template<typename Buffer>
+inline sum_type<typename Buffer::value_type> Dot(const Buffer& left, const Buffer& right, Level level = GetLevel()) {
+    using T = typename Buffer::value_type;
+    return Dispatch<T>(level, [&left, &right](auto kernels) {
+        sum_type<T> sum = 0;
+        ForEachSegmentPair(left, right, [&sum](const T* left_data, const T* right_data, size_t count) {
+            sum += decltype(kernels)::Dot(left_data, right_data, count);
+        });
+        return sum;
+    });
+}
+
+/**
+ *  @brief Returns the minimum element. The buffer must not be empty.
+*/
+template<typename Buffer>
+inline typename Buffer::value_type Min(const Buffer& buffer, Level level = GetLevel()) {
+    using T = typename Buffer::value_type;
+    assert(!buffer.IsEmpty() && "Buffer must not be empty");
+    return Dispatch<T>(level, [&buffer](auto kernels) {
+        T min = buffer.GetFront();
+        buffer.ForEachSegment([&min](const T* data, size_t count) {
+            if (count != 0) {
+                min = std::min(min, decltype(kernels)::Min(data, count));
+            }
+        });
+        return min;
+    });
+}
+
+/**
+ *  @brief Returns the maximum element. The buffer must not be empty.
+*/
+template<typename Buffer>
+inline typename Buffer::value_type Max(const Buffer& buffer, Level level = GetLevel()) {
+    using T = typename Buffer::value_type;
+    assert(!buffer.IsEmpty() && "Buffer must not be empty");
+    return Dispatch<T>(level, [&buffer](auto kernels) {
+        T max = buffer.GetFront();
+        buffer.ForEachSegment([&max](const T* data, size_t count) {
+            if (count != 0) {
+                max = std::max(max, decltype(kernels)::Max(data, count));
+            }
+        });
+        return max;
+    });
+}
+
+/**
+ *  @brief Returns the minimum and the maximum of "count" values starting at "data" in one pass.
+ *  "count" must not be 0. Used by the sorts in Sort.h for their min/max pre-pass.
+*/
+inline std::pair<int32_t, int32_t> MinMax(const int32_t* data, size_t count, Level level = GetLevel()) {
+    assert(count != 0 && "Range must not be empty");
+    return Dispatch<int32_t>(level, [data, count](auto kernels) {
+        return decltype(kernels)::MinMax(data, count);
+    });
+}
+
+/**
+ *  @brief Returns count of elements greater than "threshold".
+*/
+template<typename Buffer>
+inline size_t CountGreater(const Buffer& buffer, typename Buffer::value_type threshold, Level level = GetLevel()) {
+    using T = typename Buffer::value_type;
+    return Dispatch<T>(level, [&buffer, threshold](auto kernels) {
+        size_t result = 0;
+        buffer.ForEachSegment([&result, threshold](const T* data, size_t count) {
+            result += decltype(kernels)::CountGreater(data, count, threshold);
+        });
+        return result;
+    });
+}
+
+}
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <climits>
+#include <new>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ *  @brief Options of MappedCircularBufferArray.
+ *  huge_pages - advise the kernel to back the mapping with transparent huge pages, ignored when unsupported.
+ *  sync_every - schedule an asynchronous msync after every "sync_every" pushes, 0 leaves write back to the kernel.
+*/
+struct MappedCircularBufferOptions {
+    bool huge_pages = false;
+    std::size_t sync_every = 0;
+};
+
+/**
+ *  @brief Circular Buffer Array stored in a memory mapped file
+ *  The file holds a small header with the front index and fullness followed by the elements, so a process
+ *  that reopens the file after a crash recovers the last "_Capacity" records without parsing anything.
+ *  Front index and fullness are packed in one atomic word, the oldest elements are dropped from it before
+ *  their slots are reused and new elements are published after they are written, so the contents stay
+ *  consistent if the process is killed at any point. Surviving a power loss needs Sync or "sync_every".
+ *  Push to a full container erases the front element.
+ *  @tparam T Trivially copyable type
+ *  @tparam Capacity Container max Size
+*/
+template<typename T, std::size_t _Capacity>
+class MappedCircularBufferArray {
+    static_assert(_Capacity > 0, "_Capacity must be greater than 0");
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable to be stored in a file");
+    static_assert(_Capacity <= UINT32_MAX, "Front index and fullness must fit in 32 bits");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "State must be lock free to be shared");
+
+    static constexpr std::uint64_t magic = 0x4352434C4F474246ull; // "FBGOLCRC"
+    static constexpr std::uint32_t version = 1;
+
+    struct Header {
+        std::uint64_t magic;
+        std::uint32_t version;
+        std::uint32_t element_size;
+        std::uint64_t capacity;
+        std::atomic<std::uint64_t> state; // front index << 32 | fullness
+    };
+
+    static constexpr std::size_t header_size = 64;
+    static_assert(sizeof(Header) <= header_size, "Header must fit in its reserved space");
+    static_assert(alignof(T) <= header_size, "Elements must be aligned by the header size");
+
+    static constexpr std::size_t file_size = header_size + _Capacity * sizeof(T);
+
+    int fd_ = -1;
+    void* mapping_ = nullptr;
+    Header* header_ = nullptr;
+    T* buffer_ = nullptr;
+    MappedCircularBufferOptions options_;
+    std::size_t unsynced_ = 0;
+    bool recovered_ = false;
+
+    [[noreturn]] static void ThrowErrno(const char* what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    static inline std::size_t GetStart(std::uint64_t state) {
+        return static_cast<std::size_t>(state >> 32);
+    }
+
+    static inline std::size_t GetFullness(std::uint64_t state) {
+        return static_cast<std::size_t>(state & UINT32_MAX);
+    }
+
+    static inline std::uint64_t MakeState(std::size_t start, std::size_t fullness) {
+        return (static_cast<std::uint64_t>(start) << 32) | fullness;
+    }
+
+    static inline std::size_t GetIndex(std::size_t start, std::size_t n) {
+        std::size_t index = start + n;
+        return index < _Capacity ? index : index - _Capacity;
+    }
+
+    inline std::uint64_t LoadState() const {
+        return header_->state.load(std::memory_order_relaxed);
+    }
+
+    // Release orders element stores before the state that publishes them.
+    inline void StoreState(std::size_t start, std::size_t fullness) {
+        header_->state.store(MakeState(start, fullness), std::memory_order_release);
+    }
+
+    inline void AfterPush(std::size_t count) {
+        if (options_.sync_every == 0) return;
+        unsynced_ += count;
+        if (unsynced_ >= options_.sync_every) {
+            Sync(false);
+        }
+    }
+
+    void Unmap() {
+        if (mapping_) {
+            munmap(mapping_, file_size);
+            mapping_ = nullptr;
+        }
+        if (fd_ != -1) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+public:
+    using value_type = T;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = std::size_t;
+
+    /**
+     *  @brief Open or create the file at "path".
+     *  An existing file keeps its contents, IsRecovered returns true for it.
+     *  Throws std::system_error when the file can not be opened or mapped and std::runtime_error when
+     *  an existing file was written with another element size or capacity.
+    */
+    explicit MappedCircularBufferArray(const std::string& path, MappedCircularBufferOptions options = {})
+        : options_(options) {
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ == -1) ThrowErrno("open");
+
+        struct stat st{};
+        if (fstat(fd_, &st) == -1) {
+            Unmap();
+            ThrowErrno("fstat");
+        }
+        const bool is_new = st.st_size == 0;
+        if (!is_new && static_cast<std::size_t>(st.st_size) != file_size) {
+            Unmap();
+            throw std::runtime_error("Mapped circular buffer file has unexpected size");
+        }
+        if (is_new && ftruncate(fd_, static_cast<off_t>(file_size)) == -1) {
+            Unmap();
+            ThrowErrno("ftruncate");
+        }
+
+        mapping_ = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            Unmap();
+            ThrowErrno("mmap");
+        }
+#ifdef MADV_HUGEPAGE
+        if (options_.huge_pages) {
+            madvise(mapping_, file_size, MADV_HUGEPAGE);
+        }
+#endif
+        header_ = static_cast<Header*>(mapping_);
+        buffer_ = reinterpret_cast<T*>(static_cast<char*>(mapping_) + header_size);
+
+        // A file whose creation was interrupted has no magic yet and is initialized again
+        if (is_new || header_->magic == 0) {
+            header_->version = version;
+            header_->element_size = sizeof(T);
+            header_->capacity = _Capacity;
+            new(&header_->state) std::atomic<std::uint64_t>(MakeState(0, 0));
+            std::atomic_thread_fence(std::memory_order_release);
+            header_->magic = magic;
+            return;
+        }
+        const std::uint64_t state = LoadState();
+        if (header_->magic != magic || header_->version != version || header_->element_size != sizeof(T)
+            || header_->capacity != _Capacity || GetStart(state) >= _Capacity || GetFullness(state) > _Capacity) {
+            Unmap();
+            throw std::runtime_error("Mapped circular buffer file has incompatible header");
+        }
+        recovered_ = true;
+    }
+
+    MappedCircularBufferArray(const MappedCircularBufferArray&) = delete;
+    MappedCircularBufferArray& operator=(const MappedCircularBufferArray&) = delete;
+
+    ~MappedCircularBufferArray() {
+        Unmap();
+    }
+
+    /**
+     *  @brief Returns true if the contents were recovered from an existing file.
+    */
+    inline bool IsRecovered() const {
+        return recovered_;
+    }
+
+    /**
+     *  @brief Emplace element at the back of the container
+     *  If the container is full the front element is overwritten.
+     *  @return T*  A pointer to the construct element.
+    */
+    template<typename... Args>
+    inline pointer EmplaceBack(Args&& ... args) {
+        return PushBack(T(std::forward<Args>(args)...));
+    }
+
+    /**
+     *  @brief Push element at the back of the container
+     *  If the container is full the front element is overwritten.
+     *  @return T*  A pointer to the copied element.
+    */
+    inline pointer PushBack(const T& value) {
+        const std::uint64_t state = LoadState();
+        std::size_t start = GetStart(state);
+        std::size_t fullness = GetFullness(state);
+        if (fullness == _Capacity) {
+            start = GetIndex(start, 1);
+            --fullness;
+            StoreState(start, fullness);
+        }
+        T* back_ptr = buffer_ + GetIndex(start, fullness);
+        std::memcpy(static_cast<void*>(back_ptr), &value, sizeof(T));
+        StoreState(start, fullness + 1);
+        AfterPush(1);
+        return back_ptr;
+    }
+
+    /**
+     *  @brief Push "count" elements starting at "data" at the back of the container.
+     *  When there are more elements than free space, front elements are overwritten.
+     *  Elements are copied with at most two memcpy calls, split at the wrap point.
+     *  @return Count of pushed elements.
+    */
+    inline std::size_t PushBackRange(const T* data, std::size_t count) {
+        const std::size_t pushed = count;
+        if (count > _Capacity) {
+            data += count - _Capacity;
+            count = _Capacity;
+        }
+        const std::uint64_t state = LoadState();
+        std::size_t start = GetStart(state);
+        std::size_t fullness = GetFullness(state);
+        if (fullness + count > _Capacity) {
+            // Drop the front elements whose slots are reused before writing into them
+            const std::size_t dropped = fullness + count - _Capacity;
+            start = GetIndex(start, dropped);
+            fullness -= dropped;
+            StoreState(start, fullness);
+        }
+        const std::size_t write_index = GetIndex(start, fullness);
+        const std::size_t first_count = std::min(count, _Capacity - write_index);
+        std::memcpy(static_cast<void*>(buffer_ + write_index), data, first_count * sizeof(T));
+        std::memcpy(static_cast<void*>(buffer_), data + first_count, (count - first_count) * sizeof(T));
+        StoreState(start, fullness + count);
+        AfterPush(pushed);
+        return pushed;
+    }
+
+    /**
+     *  @brief Erase first element in container
+    */
+    inline void PopFront() {
+        const std::uint64_t state = LoadState();
+        assert(0 < GetFullness(state) && "Fullness must be greater than 0");
+        StoreState(GetIndex(GetStart(state), 1), GetFullness(state) - 1);
+    }
+
+    /**
+     *  @brief Returns a reference to the element at the front position in the container.
+    */
+    inline const_reference GetFront() const {
+        assert(0 < Size() && "Fullness must be greater than 0");
+        return buffer_[GetStart(LoadState())];
+    }
+
+    /**
+     *  @brief Returns a reference to the element at the back position in the container.
+    */
+    inline const_reference GetBack() const {
+        const std::uint64_t state = LoadState();
+        assert(0 < GetFullness(state) && "Fullness must be greater than 0");
+        return buffer_[GetIndex(GetStart(state), GetFullness(state) - 1)];
+    }
+
+    /**
+     *  @brief Write dirty pages back to the file.
+     *  @param wait If true, returns after the pages are written, otherwise only schedules the write back.
+    */
+    inline void Sync(bool wait = true) {
+        unsynced_ = 0;
+        if (msync(mapping_, file_size, wait ? MS_SYNC : MS_ASYNC) == -1) {
+            ThrowErrno("msync");
+        }
+    }
+
+    /**
+     *  @brief Returns count of elements in the container.
+    */
+    inline std::size_t Size() const {
+        return GetFullness(LoadState());
+    }
+
+    /**
+     *  @brief Returns Capacity of the container.
+    */
+    inline std::size_t Capacity() const {
+        return _Capacity;
+    }
+
+    /**
+     *  @brief Erase all in the container.
+    */
+    inline void Clear() {
+        StoreState(0, 0);
+    }
+
+    /**
+     *  @brief Returns true if the container is IsEmpty.
+    */
+    inline bool IsEmpty() const {
+        return Size() == 0;
+    }
+
+    /**
+     *  @brief Returns true if the container is full.
+    */
+    inline bool IsFull() const {
+        return Size() == _Capacity;
+    }
+
+    const_reference operator[](std::size_t n) const {
+        const std::uint64_t state = LoadState();
+        assert(n < GetFullness(state) && "n must be less than fullness.");
+        return buffer_[GetIndex(GetStart(state), n)];
+    }
+};
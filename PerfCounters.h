@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ *  @brief Hardware performance counters of the calling thread and of the threads it starts, over perf_event_open
+ *  Threads started while the counters are enabled are counted too, their counts are added once they exit, so
+ *  a function that joins its threads is counted fully. Every event is opened on its own, so an event the CPU
+ *  or the virtual machine does not provide is reported as unavailable while the others keep counting. Only user
+ *  space is counted, which perf_event_paranoid up to 2 allows to unprivileged processes. On other systems, or
+ *  when perf_event_open is denied, nothing is available and Enable/Disable do nothing. Values are scaled by time
+ *  enabled over time running when the kernel multiplexes more events than the PMU has counters.
+*/
+class PerfCounters {
+public:
+    enum Event : std::size_t {
+        Cycles,
+        Instructions,
+        CacheReferences,
+        CacheMisses,
+        BranchMisses,
+        L1DReadMisses,
+        event_count
+    };
+
+    /**
+     *  @brief Returns the name of the event as printed in reports.
+    */
+    static inline const char* GetName(std::size_t event) {
+        static const char* const names[event_count] = {
+            "cycles", "instructions", "cache-references", "cache-misses", "branch-misses", "L1d-read-misses"
+        };
+        return names[event];
+    }
+
+    /**
+     *  @brief Counts accumulated since the last Reset, "available[event]" is false for events that could not be opened.
+    */
+    struct Values {
+        double counts[event_count] = {};
+        bool available[event_count] = {};
+    };
+
+private:
+    int fds_[event_count];
+
+#ifdef __linux__
+    static int Open(std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    template<typename Func>
+    inline void ForEachOpen(Func&& func) const {
+        for (std::size_t i = 0; i < event_count; ++i) {
+            if (fds_[i] != -1) func(i, fds_[i]);
+        }
+    }
+
+public:
+    PerfCounters() {
+        for (int& fd : fds_) fd = -1;
+#ifdef __linux__
+        fds_[Cycles] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds_[Instructions] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds_[CacheReferences] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES);
+        fds_[CacheMisses] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds_[BranchMisses] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        fds_[L1DReadMisses] = Open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                                                       | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                                       | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        for (int& fd : fds_) {
+            if (fd < 0) fd = -1;
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+#ifdef __linux__
+        ForEachOpen([](std::size_t, int fd) { close(fd); });
+#endif
+    }
+
+    /**
+     *  @brief Returns true if at least one event is counted.
+    */
+    inline bool IsAvailable() const {
+        for (int fd : fds_) {
+            if (fd != -1) return true;
+        }
+        return false;
+    }
+
+    /**
+     *  @brief Zero all counts.
+    */
+    inline void Reset() {
+#ifdef __linux__
+        ForEachOpen([](std::size_t, int fd) { ioctl(fd, PERF_EVENT_IOC_RESET, 0); });
+#endif
+    }
+
+    /**
+     *  @brief Start counting, counts accumulate over every Enable/Disable pair until Reset.
+    */
+    inline void Enable() {
+#ifdef __linux__
+        ForEachOpen([](std::size_t, int fd) { ioctl(fd, PERF_EVENT_IOC_ENABLE, 0); });
+#endif
+    }
+
+    /**
+     *  @brief Stop counting.
+    */
+    inline void Disable() {
+#ifdef __linux__
+        ForEachOpen([](std::size_t, int fd) { ioctl(fd, PERF_EVENT_IOC_DISABLE, 0); });
+#endif
+    }
+
+    /**
+     *  @brief Returns the counts accumulated since the last Reset.
+    */
+    inline Values Read() const {
+        Values values;
+#ifdef __linux__
+        ForEachOpen([&values](std::size_t event, int fd) {
+            std::uint64_t data[3] = {}; // value, time enabled, time running
+            if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) return;
+            values.available[event] = true;
+            values.counts[event] = data[2] == 0 ? 0.0 : static_cast<double>(data[0])
+                                                        * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        });
+#endif
+        return values;
+    }
+};
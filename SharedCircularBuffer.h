@@ -0,0 +1,292 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CircularBuffer.h"
+
+/**
+ *  @brief Single-producer/single-consumer Circular Buffer Array shared between processes
+ *  Storage is a POSIX shared memory segment holding a magic/version header, the head and tail positions
+ *  on their own cache lines and the elements, with the same position arithmetic as SpscCircularBufferArray.
+ *  Each side maps the segment with AttachProducer or AttachConsumer, whichever comes first creates it.
+ *  Cached copies of the opposite position stay in the process, so they are never shared.
+ *  A side that died without detaching keeps its role taken until the segment is removed with Unlink.
+ *  @tparam T Trivially copyable type
+ *  @tparam Capacity Container max Size
+*/
+template<typename T, std::size_t _Capacity>
+class SharedSpscCircularBufferArray {
+    static_assert(_Capacity > 0, "_Capacity must be greater than 0");
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable to be shared between processes");
+    static_assert(alignof(T) <= cache_line_size, "Elements must be aligned by the cache line size");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Positions must be lock free to be shared");
+
+    static constexpr std::uint64_t magic = 0x5053434352414853ull; // "SHARCCSP"
+    static constexpr std::uint32_t version = 1;
+
+    using Position = SpscPosition<_Capacity>;
+
+    struct Control {
+        std::atomic<std::uint64_t> magic;
+        std::uint32_t version;
+        std::uint32_t element_size;
+        std::uint64_t capacity;
+        std::atomic<std::uint32_t> producer_attached;
+        std::atomic<std::uint32_t> consumer_attached;
+
+        // Consumer side
+        alignas(cache_line_size) std::atomic<std::uint64_t> head;
+
+        // Producer side
+        alignas(cache_line_size) std::atomic<std::uint64_t> tail;
+    };
+
+    static constexpr std::size_t segment_size = sizeof(Control) + _Capacity * sizeof(T);
+
+    int fd_ = -1;
+    void* mapping_ = nullptr;
+    Control* control_ = nullptr;
+    T* buffer_ = nullptr;
+    bool is_producer_ = false;
+    std::size_t cached_position_ = 0;
+
+    [[noreturn]] static void ThrowErrno(const char* what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    SharedSpscCircularBufferArray(const std::string& name, bool is_producer, std::chrono::milliseconds timeout)
+        : is_producer_(is_producer) {
+        try {
+            Map(name, timeout);
+            std::atomic<std::uint32_t>& attached = is_producer ? control_->producer_attached
+                                                               : control_->consumer_attached;
+            if (attached.exchange(1, std::memory_order_acq_rel) != 0) {
+                throw std::runtime_error(is_producer ? "Producer is already attached" : "Consumer is already attached");
+            }
+            cached_position_ = is_producer ? control_->head.load(std::memory_order_acquire)
+                                           : control_->tail.load(std::memory_order_acquire);
+        } catch (...) {
+            Unmap();
+            throw;
+        }
+    }
+
+    void Map(const std::string& name, std::chrono::milliseconds timeout) {
+        bool is_new = true;
+        fd_ = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd_ == -1 && errno == EEXIST) {
+            is_new = false;
+            fd_ = shm_open(name.c_str(), O_RDWR, 0600);
+        }
+        if (fd_ == -1) ThrowErrno("shm_open");
+
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        if (is_new) {
+            if (ftruncate(fd_, static_cast<off_t>(segment_size)) == -1) ThrowErrno("ftruncate");
+        } else {
+            // The creator may not have sized the segment yet
+            struct stat st{};
+            while (true) {
+                if (fstat(fd_, &st) == -1) ThrowErrno("fstat");
+                if (st.st_size != 0) break;
+                if (std::chrono::steady_clock::now() > deadline) {
+                    throw std::runtime_error("Shared circular buffer segment is not initialized");
+                }
+                std::this_thread::yield();
+            }
+            if (static_cast<std::size_t>(st.st_size) != segment_size) {
+                throw std::runtime_error("Shared circular buffer segment has unexpected size");
+            }
+        }
+
+        mapping_ = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            ThrowErrno("mmap");
+        }
+        control_ = static_cast<Control*>(mapping_);
+        buffer_ = reinterpret_cast<T*>(static_cast<char*>(mapping_) + sizeof(Control));
+
+        if (is_new) {
+            new(control_) Control{};
+            control_->version = version;
+            control_->element_size = sizeof(T);
+            control_->capacity = _Capacity;
+            control_->magic.store(magic, std::memory_order_release);
+            return;
+        }
+        while (control_->magic.load(std::memory_order_acquire) != magic) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                throw std::runtime_error("Shared circular buffer segment is not initialized");
+            }
+            std::this_thread::yield();
+        }
+        if (control_->version != version || control_->element_size != sizeof(T) || control_->capacity != _Capacity) {
+            throw std::runtime_error("Shared circular buffer segment has incompatible header");
+        }
+    }
+
+    void Unmap() {
+        if (mapping_) {
+            munmap(mapping_, segment_size);
+            mapping_ = nullptr;
+            control_ = nullptr;
+            buffer_ = nullptr;
+        }
+        if (fd_ != -1) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    /**
+     *  @brief Map the segment "name" as its producer, creating it if needed.
+     *  Waits up to "timeout" for a segment that is being created by the other side.
+     *  Throws std::system_error when the segment can not be opened or mapped and std::runtime_error when
+     *  it has another layout or already has a producer.
+    */
+    static SharedSpscCircularBufferArray AttachProducer(const std::string& name,
+                                                        std::chrono::milliseconds timeout = std::chrono::seconds(1)) {
+        return SharedSpscCircularBufferArray(name, true, timeout);
+    }
+
+    /**
+     *  @brief Map the segment "name" as its consumer, creating it if needed.
+     *  Throws as AttachProducer.
+    */
+    static SharedSpscCircularBufferArray AttachConsumer(const std::string& name,
+                                                        std::chrono::milliseconds timeout = std::chrono::seconds(1)) {
+        return SharedSpscCircularBufferArray(name, false, timeout);
+    }
+
+    /**
+     *  @brief Remove the segment "name". Processes that have it mapped keep using it.
+     *  @return false if there is no such segment.
+    */
+    static bool Unlink(const std::string& name) {
+        return shm_unlink(name.c_str()) == 0;
+    }
+
+    SharedSpscCircularBufferArray(SharedSpscCircularBufferArray&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1)), mapping_(std::exchange(other.mapping_, nullptr)),
+          control_(std::exchange(other.control_, nullptr)), buffer_(std::exchange(other.buffer_, nullptr)),
+          is_producer_(other.is_producer_), cached_position_(other.cached_position_) {}
+
+    SharedSpscCircularBufferArray(const SharedSpscCircularBufferArray&) = delete;
+    SharedSpscCircularBufferArray& operator=(const SharedSpscCircularBufferArray&) = delete;
+    SharedSpscCircularBufferArray& operator=(SharedSpscCircularBufferArray&&) = delete;
+
+    /**
+     *  @brief Release the role and unmap the segment, the segment itself is kept.
+    */
+    ~SharedSpscCircularBufferArray() {
+        if (control_) {
+            (is_producer_ ? control_->producer_attached : control_->consumer_attached)
+                .store(0, std::memory_order_release);
+        }
+        Unmap();
+    }
+
+    /**
+     *  @brief Returns true if attached as the producer.
+    */
+    inline bool IsProducer() const {
+        return is_producer_;
+    }
+
+    /**
+     *  @brief Construct element at the back of the container. Producer only.
+     *  @return false if the container is full, nothing is constructed in that case.
+    */
+    template<typename... Args>
+    inline bool TryEmplace(Args&& ... args) {
+        assert(is_producer_ && "Only the producer may push");
+        const std::size_t tail = control_->tail.load(std::memory_order_relaxed);
+        if (Position::Distance(cached_position_, tail) == _Capacity) {
+            cached_position_ = control_->head.load(std::memory_order_acquire);
+            if (Position::Distance(cached_position_, tail) == _Capacity) {
+                return false;
+            }
+        }
+        new(buffer_ + Position::GetIndex(tail)) T(std::forward<Args>(args)...);
+        control_->tail.store(Position::Advance(tail), std::memory_order_release);
+        return true;
+    }
+
+    /**
+     *  @brief Push element at the back of the container. Producer only.
+     *  @return false if the container is full.
+    */
+    template<typename U = T>
+    inline bool TryPush(U&& value) {
+        return TryEmplace(std::forward<U>(value));
+    }
+
+    /**
+     *  @brief Copy the front element to "value" and erase it. Consumer only.
+     *  @return false if the container is empty, "value" is untouched in that case.
+    */
+    inline bool TryPop(T& value) {
+        assert(!is_producer_ && "Only the consumer may pop");
+        const std::size_t head = control_->head.load(std::memory_order_relaxed);
+        if (head == cached_position_) {
+            cached_position_ = control_->tail.load(std::memory_order_acquire);
+            if (head == cached_position_) {
+                return false;
+            }
+        }
+        value = buffer_[Position::GetIndex(head)];
+        control_->head.store(Position::Advance(head), std::memory_order_release);
+        return true;
+    }
+
+    /**
+     *  @brief Returns count of elements in the container.
+     *  The value is exact only when the other side is idle.
+    */
+    inline std::size_t Size() const {
+        return Position::Distance(control_->head.load(std::memory_order_acquire),
+                                  control_->tail.load(std::memory_order_acquire));
+    }
+
+    /**
+     *  @brief Returns Capacity of the container.
+    */
+    inline std::size_t Capacity() const {
+        return _Capacity;
+    }
+
+    /**
+     *  @brief Returns true if the container is empty.
+    */
+    inline bool IsEmpty() const {
+        return Size() == 0;
+    }
+
+    /**
+     *  @brief Returns true if the container is full.
+    */
+    inline bool IsFull() const {
+        return Size() == _Capacity;
+    }
+};
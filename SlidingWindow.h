@@ -0,0 +1,310 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "CircularBuffer.h"
+
+/**
+ *  @brief Associative operations for SlidingWindowAggregator.
+*/
+template<typename T>
+struct MinOp {
+    const T& operator()(const T& left, const T& right) const {
+        return right < left ? right : left;
+    }
+};
+
+template<typename T>
+struct MaxOp {
+    const T& operator()(const T& left, const T& right) const {
+        return left < right ? right : left;
+    }
+};
+
+/**
+ *  @brief Rolling statistics over the last "_Window" samples
+ *  Every PushBack evicts the oldest sample from a full window and updates the aggregates in O(1) amortized time:
+ *  sum and mean/variance by Welford's update with removal, min and max by monotonic queues of candidates
+ *  stored in CircularBufferArray.
+ *  @tparam T Arithmetic type
+ *  @tparam Window Count of the last samples aggregated
+ *  @tparam IsHeap Storage selection of the underlying CircularBufferArray
+*/
+template<typename T, std::size_t _Window, typename IsHeap = bool>
+class SlidingWindowStats {
+    static_assert(std::is_arithmetic_v<T>, "T must be arithmetic");
+
+public:
+    using value_type = T;
+    using sum_type = std::conditional_t<std::is_floating_point_v<T>, double,
+                                        std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>>;
+
+private:
+    // Candidate for min or max with the sequence number of its sample.
+    using candidate_type = std::pair<T, std::size_t>;
+
+    CircularBufferArray<T, _Window, IsHeap> samples_;
+    CircularBufferArray<candidate_type, _Window, IsHeap> min_candidates_;
+    CircularBufferArray<candidate_type, _Window, IsHeap> max_candidates_;
+    std::size_t sequence_ = 0;
+    sum_type sum_ = 0;
+    double mean_ = 0;
+    double m2_ = 0;
+
+    template<typename Compare>
+    static inline void PushCandidate(CircularBufferArray<candidate_type, _Window, IsHeap>& candidates,
+                                     T value, std::size_t sequence, Compare dominates) {
+        while (!candidates.IsEmpty() && !dominates(candidates.GetBack().first, value)) {
+            candidates.PopBack();
+        }
+        candidates.PushBack(candidate_type(value, sequence));
+    }
+
+    static inline void EvictCandidate(CircularBufferArray<candidate_type, _Window, IsHeap>& candidates,
+                                      std::size_t sequence) {
+        if (!candidates.IsEmpty() && candidates.GetFront().second == sequence) {
+            candidates.PopFront();
+        }
+    }
+
+public:
+
+    /**
+     *  @brief Push sample at the back of the window, the oldest sample is evicted when the window is full.
+    */
+    inline void PushBack(T value) {
+        const double x = static_cast<double>(value);
+        if (samples_.IsFull()) {
+            const T evicted = samples_.GetFront();
+            const double y = static_cast<double>(evicted);
+            EvictCandidate(min_candidates_, sequence_ - _Window);
+            EvictCandidate(max_candidates_, sequence_ - _Window);
+            sum_ = sum_ - static_cast<sum_type>(evicted) + static_cast<sum_type>(value);
+
+            const double old_mean = mean_;
+            mean_ += (x - y) / static_cast<double>(_Window);
+            m2_ += (x - y) * (x - mean_ + y - old_mean);
+        } else {
+            sum_ += static_cast<sum_type>(value);
+
+            const double delta = x - mean_;
+            mean_ += delta / static_cast<double>(samples_.Size() + 1);
+            m2_ += delta * (x - mean_);
+        }
+        samples_.PushBack(value);
+        PushCandidate(min_candidates_, value, sequence_, std::less<T>());
+        PushCandidate(max_candidates_, value, sequence_, std::greater<T>());
+        ++sequence_;
+    }
+
+    /**
+     *  @brief Returns sum of the samples in the window.
+    */
+    inline sum_type Sum() const {
+        return sum_;
+    }
+
+    /**
+     *  @brief Returns mean of the samples in the window.
+    */
+    inline double Mean() const {
+        return mean_;
+    }
+
+    /**
+     *  @brief Returns population variance of the samples in the window.
+    */
+    inline double Variance() const {
+        return samples_.IsEmpty() ? 0.0 : std::max(0.0, m2_ / static_cast<double>(samples_.Size()));
+    }
+
+    /**
+     *  @brief Returns sample variance of the samples in the window, 0 for less than two samples.
+    */
+    inline double SampleVariance() const {
+        return samples_.Size() < 2 ? 0.0 : std::max(0.0, m2_ / static_cast<double>(samples_.Size() - 1));
+    }
+
+    /**
+     *  @brief Returns the minimum sample in the window.
+    */
+    inline T Min() const {
+        assert(!IsEmpty() && "Window must not be empty");
+        return min_candidates_.GetFront().first;
+    }
+
+    /**
+     *  @brief Returns the maximum sample in the window.
+    */
+    inline T Max() const {
+        assert(!IsEmpty() && "Window must not be empty");
+        return max_candidates_.GetFront().first;
+    }
+
+    /**
+     *  @brief Returns the samples in the window, front is the oldest.
+    */
+    inline const CircularBufferArray<T, _Window, IsHeap>& Samples() const {
+        return samples_;
+    }
+
+    /**
+     *  @brief Returns count of samples in the window.
+    */
+    inline std::size_t Size() const {
+        return samples_.Size();
+    }
+
+    /**
+     *  @brief Returns Capacity of the window.
+    */
+    inline std::size_t Capacity() const {
+        return _Window;
+    }
+
+    /**
+     *  @brief Erase all samples.
+    */
+    inline void Clear() {
+        samples_.Clear();
+        min_candidates_.Clear();
+        max_candidates_.Clear();
+        sequence_ = 0;
+        sum_ = 0;
+        mean_ = 0;
+        m2_ = 0;
+    }
+
+    /**
+     *  @brief Returns true if the window is empty.
+    */
+    inline bool IsEmpty() const {
+        return samples_.IsEmpty();
+    }
+
+    /**
+     *  @brief Returns true if the window is full.
+    */
+    inline bool IsFull() const {
+        return samples_.IsFull();
+    }
+};
+
+/**
+ *  @brief Aggregate of the last "_Window" values under an associative operation
+ *  Two-stack queue: newly pushed values form the back stack with one running aggregate, evicted values are
+ *  taken from the front stack which holds the aggregate of every suffix. When the front stack is empty the back
+ *  stack is flipped into it in one pass, so each value is combined a constant number of times and PushBack is
+ *  O(1) amortized. The operation only has to be associative, the order of values is preserved.
+ *  @tparam T Type
+ *  @tparam Window Count of the last values aggregated
+ *  @tparam Op Associative operation "T(const T&, const T&)", e.g. std::plus<T>, MinOp<T>, MaxOp<T>
+ *  @tparam IsHeap Storage selection of the underlying CircularBufferArray
+*/
+template<typename T, std::size_t _Window, typename Op, typename IsHeap = bool>
+class SlidingWindowAggregator {
+    CircularBufferArray<T, _Window, IsHeap> values_;
+    // Aggregates of the front stack, back is the aggregate from the oldest value to the last flipped one.
+    CircularBufferArray<T, _Window, IsHeap> front_aggregates_;
+    T back_aggregate_{};
+    std::size_t back_count_ = 0;
+    Op op_;
+
+    void Flip() {
+        assert(back_count_ == values_.Size() && "Front stack must be empty");
+        front_aggregates_.Clear();
+        auto it = values_.crbegin();
+        T aggregate = *it;
+        front_aggregates_.PushBack(aggregate);
+        for (++it; it != values_.crend(); ++it) {
+            aggregate = op_(*it, aggregate);
+            front_aggregates_.PushBack(aggregate);
+        }
+        back_count_ = 0;
+    }
+
+public:
+    using value_type = T;
+
+    explicit SlidingWindowAggregator(Op op = Op()) : op_(std::move(op)) {}
+
+    /**
+     *  @brief Push value at the back of the window, the oldest value is evicted when the window is full.
+    */
+    inline void PushBack(const T& value) {
+        if (values_.IsFull()) {
+            PopFront();
+        }
+        back_aggregate_ = back_count_ == 0 ? value : op_(back_aggregate_, value);
+        ++back_count_;
+        values_.PushBack(value);
+    }
+
+    /**
+     *  @brief Evict the oldest value.
+    */
+    inline void PopFront() {
+        assert(!IsEmpty() && "Window must not be empty");
+        if (front_aggregates_.IsEmpty()) {
+            Flip();
+        }
+        front_aggregates_.PopBack();
+        values_.PopFront();
+    }
+
+    /**
+     *  @brief Returns aggregate of the values in the window, from the oldest to the newest.
+    */
+    inline T Get() const {
+        assert(!IsEmpty() && "Window must not be empty");
+        if (front_aggregates_.IsEmpty()) {
+            return back_aggregate_;
+        }
+        if (back_count_ == 0) {
+            return front_aggregates_.GetBack();
+        }
+        return op_(front_aggregates_.GetBack(), back_aggregate_);
+    }
+
+    /**
+     *  @brief Returns count of values in the window.
+    */
+    inline std::size_t Size() const {
+        return values_.Size();
+    }
+
+    /**
+     *  @brief Returns Capacity of the window.
+    */
+    inline std::size_t Capacity() const {
+        return _Window;
+    }
+
+    /**
+     *  @brief Erase all values.
+    */
+    inline void Clear() {
+        values_.Clear();
+        front_aggregates_.Clear();
+        back_count_ = 0;
+    }
+
+    /**
+     *  @brief Returns true if the window is empty.
+    */
+    inline bool IsEmpty() const {
+        return values_.IsEmpty();
+    }
+
+    /**
+     *  @brief Returns true if the window is full.
+    */
+    inline bool IsFull() const {
+        return values_.IsFull();
+    }
+};
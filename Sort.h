@@ -0,0 +1,671 @@
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CircularBufferSimd.h"
+
+/**
+ *  @brief Max count of catalog entries HybridSort allocates for counting sort, 32 MB of std::size_t counters.
+*/
+constexpr std::size_t counting_sort_max_range = std::size_t(1) << 22;
+
+/**
+ *  @brief HybridSort uses counting sort while the value range is at most this many times the element count.
+*/
+constexpr std::size_t counting_sort_range_per_element = 2;
+
+/**
+ *  @brief Count of sub-histograms BuildHistogram spreads consecutive elements over.
+*/
+constexpr std::size_t histogram_sub_count = 4;
+
+/**
+ *  @brief BuildHistogram uses sub-histograms only up to this many buckets, larger ones would not fit the cache
+ *  together and a single one is faster.
+*/
+constexpr std::size_t histogram_sub_max_buckets = std::size_t(1) << 14;
+
+namespace {
+// Call "count(data[i], i % sub_count)" for the "size" elements, sub_count is the length of "subs". Groups of
+// sub_count elements are unrolled by the fold, so the sub index is a constant, the tail goes to sub 0.
+template<typename Item, std::size_t... _Subs, typename CountFunc>
+inline void CountInterleaved(const Item* data, std::size_t size, std::index_sequence<_Subs...> subs,
+                             CountFunc&& count) {
+    const std::size_t unrolled = size - size % subs.size();
+    for (std::size_t i = 0; i < unrolled; i += subs.size()) {
+        (count(data[i + _Subs], _Subs), ...);
+    }
+    for (std::size_t i = unrolled; i < size; ++i) {
+        count(data[i], 0);
+    }
+}
+}
+
+/**
+ *  @brief Returns count of 32-bit entries of the sub-histogram scratch BuildHistogram needs for "bucket_count"
+ *  buckets, 0 when it counts straight into the histogram.
+*/
+constexpr std::size_t GetHistogramScratchSize(std::size_t bucket_count, std::size_t sub_count = histogram_sub_count) {
+    // A cache line of padding between sub-histograms, so equal buckets of different ones do not alias in L1
+    return sub_count == 1 || bucket_count > histogram_sub_max_buckets
+           ? 0 : sub_count * (bucket_count + 64 / sizeof(std::uint32_t));
+}
+
+/**
+ *  @brief Count "bucket(data[i])" of "size" elements into "histogram" of "bucket_count" entries
+ *  A run of equal buckets makes every increment wait for the store of the previous one. Consecutive elements are
+ *  counted into "_SubCount" separate 32-bit sub-histograms instead, so the increments of a run are independent,
+ *  and the sub-histograms are summed at the end. The loop has no branches besides the loop condition.
+ *  "histogram" is overwritten, "bucket" must return values below "bucket_count". "sub_histograms" is caller owned
+ *  scratch of GetHistogramScratchSize(bucket_count, _SubCount) entries, so this overload does not allocate.
+ *  @tparam SubCount Count of sub-histograms, 1 counts straight into "histogram"
+*/
+template<std::size_t _SubCount = histogram_sub_count, typename Item, typename BucketFunc>
+inline void BuildHistogram(const Item* data, std::size_t size, std::size_t bucket_count, std::size_t* histogram,
+                           std::uint32_t* sub_histograms, BucketFunc&& bucket) {
+    static_assert(_SubCount > 0, "Sub-histogram count must be positive");
+    std::fill(histogram, histogram + bucket_count, 0);
+    const std::size_t scratch_size = GetHistogramScratchSize(bucket_count, _SubCount);
+    if (scratch_size == 0 || size > UINT32_MAX || size < _SubCount) {
+        for (std::size_t i = 0; i < size; ++i) {
+            ++histogram[bucket(data[i])];
+        }
+        return;
+    }
+
+    const std::size_t stride = scratch_size / _SubCount;
+    std::fill(sub_histograms, sub_histograms + scratch_size, 0);
+    CountInterleaved(data, size, std::make_index_sequence<_SubCount>(), [&](const Item& item, std::size_t sub) {
+        ++sub_histograms[sub * stride + bucket(item)];
+    });
+    for (std::size_t sub = 0; sub < _SubCount; ++sub) {
+        const std::uint32_t* const sub_counts = sub_histograms + sub * stride;
+        for (std::size_t k = 0; k < bucket_count; ++k) {
+            histogram[k] += sub_counts[k];
+        }
+    }
+}
+
+/**
+ *  @brief BuildHistogram with sub-histogram scratch allocated for this call.
+*/
+template<std::size_t _SubCount = histogram_sub_count, typename Item, typename BucketFunc>
+inline void BuildHistogram(const Item* data, std::size_t size, std::size_t bucket_count, std::size_t* histogram,
+                           BucketFunc&& bucket) {
+    std::vector<std::uint32_t> sub_histograms(GetHistogramScratchSize(bucket_count, _SubCount));
+    BuildHistogram<_SubCount>(data, size, bucket_count, histogram, sub_histograms.data(), bucket);
+}
+
+namespace {
+// Counting sort of values known to lie in [lo, lo + range).
+inline void CountingSortRange(int* data, std::size_t size, int lo, std::size_t range) {
+    std::vector<std::size_t> counts(range);
+    BuildHistogram(data, size, range, counts.data(), [lo](int value) {
+        return static_cast<std::size_t>(static_cast<std::int64_t>(value) - lo);
+    });
+    int* out = data;
+    for (std::size_t k = 0; k < range; ++k) {
+        const int value = static_cast<int>(lo + static_cast<std::int64_t>(k));
+        out = std::fill_n(out, counts[k], value);
+    }
+}
+}
+
+/**
+ *  @brief Counting sort of "nums" in O(n + k), k is the range of the values
+ *  The first pass finds min and max with simd::MinMax, the second counts every value by BuildHistogram into
+ *  a catalog of (max - min + 1) counters, the third writes the values back in order.
+*/
+inline void CountingSort(std::vector<int>& nums) {
+    if (nums.size() < 2) return;
+    const auto [lo, hi] = simd::MinMax(nums.data(), nums.size());
+    if (lo == hi) return;
+    CountingSortRange(nums.data(), nums.size(), lo,
+                      static_cast<std::size_t>(static_cast<std::int64_t>(hi) - lo) + 1);
+}
+
+/**
+ *  @brief Order preserving mapping of a key to an unsigned integer of the same size.
+ *  Unsigned values map to themselves, signed values get the sign bit flipped, floating point values get the sign
+ *  bit flipped when positive and all bits flipped when negative, so -0.0 orders before +0.0 and NaN with the sign
+ *  bit set orders first, NaN without it orders last.
+*/
+template<typename T, typename = void>
+struct RadixKey;
+
+template<typename T>
+struct RadixKey<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+    using type = std::make_unsigned_t<T>;
+    static constexpr type sign_bit = std::is_signed_v<T> ? type(1) << (sizeof(T) * 8 - 1) : 0;
+
+    static inline type Get(T value) {
+        return static_cast<type>(value) ^ sign_bit;
+    }
+};
+
+template<typename T>
+struct RadixKey<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Only IEEE 754 single and double precision are supported");
+    using type = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+    static constexpr type sign_bit = type(1) << (sizeof(T) * 8 - 1);
+
+    static inline type Get(T value) {
+        type bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        return bits & sign_bit ? ~bits : bits | sign_bit;
+    }
+};
+
+/**
+ *  @brief Digit layout of RadixKey of T split into "_DigitBits" wide digits, the lowest digit is pass 0.
+*/
+template<typename T, unsigned _DigitBits>
+struct RadixDigits {
+    static_assert(0 < _DigitBits && _DigitBits <= 16, "_DigitBits must be in [1, 16]");
+
+    using key_type = typename RadixKey<T>::type;
+
+    static constexpr unsigned key_bits = sizeof(key_type) * 8;
+    static constexpr unsigned pass_count = (key_bits + _DigitBits - 1) / _DigitBits;
+    static constexpr std::size_t bucket_count = std::size_t(1) << _DigitBits;
+    static constexpr key_type digit_mask = static_cast<key_type>(bucket_count - 1);
+
+    static inline std::size_t GetDigit(T value, unsigned pass) {
+        return static_cast<std::size_t>((RadixKey<T>::Get(value) >> (pass * _DigitBits)) & digit_mask);
+    }
+};
+
+namespace {
+// Stable LSD radix sort of "size" items at "data" by "key(item)" of type K, "scratch" holds "size" items.
+// Histograms of all digits are built in one pass, passes where every key has the same digit are skipped.
+template<typename K, unsigned _DigitBits, typename Item, typename KeyFunc>
+inline void RadixSortItems(Item* data, Item* scratch, std::size_t size, std::vector<std::size_t>& histograms,
+                           KeyFunc&& key) {
+    using Digits = RadixDigits<K, _DigitBits>;
+    constexpr unsigned pass_count = Digits::pass_count;
+    constexpr std::size_t bucket_count = Digits::bucket_count;
+
+    histograms.assign(pass_count * bucket_count, 0);
+    for (std::size_t i = 0; i < size; ++i) {
+        const typename Digits::key_type radix_key = RadixKey<K>::Get(key(data[i]));
+        for (unsigned pass = 0; pass < pass_count; ++pass) {
+            ++histograms[pass * bucket_count + ((radix_key >> (pass * _DigitBits)) & Digits::digit_mask)];
+        }
+    }
+
+    Item* from = data;
+    Item* to = scratch;
+    for (unsigned pass = 0; pass < pass_count; ++pass) {
+        std::size_t* offsets = histograms.data() + pass * bucket_count;
+        if (offsets[Digits::GetDigit(key(from[0]), pass)] == size) continue;
+
+        std::size_t sum = 0;
+        for (std::size_t bucket = 0; bucket < bucket_count; ++bucket) {
+            const std::size_t count = offsets[bucket];
+            offsets[bucket] = sum;
+            sum += count;
+        }
+        for (std::size_t i = 0; i < size; ++i) {
+            to[offsets[Digits::GetDigit(key(from[i]), pass)]++] = from[i];
+        }
+        std::swap(from, to);
+    }
+    if (from != data) {
+        std::copy(from, from + size, data);
+    }
+}
+}
+
+/**
+ *  @brief LSD radix sort of 8, 16, 32 or 64-bit integer and floating point keys
+ *  One pass over the input builds the histograms of every digit, then each digit is scattered in a stable pass
+ *  between the data and the scratch buffer. Passes where every key has the same digit, e.g. the high digits of
+ *  small values, are skipped. The scratch buffer is kept between calls, so sorting many arrays with one sorter
+ *  allocates only when an array is larger than every previous one.
+ *  @tparam T Key type
+ *  @tparam DigitBits Bits per pass, 8 gives 256 buckets that fit L1, 11 needs fewer passes for 32 and 64-bit keys
+*/
+template<typename T, unsigned _DigitBits = 8>
+class RadixSorter {
+    std::vector<T> scratch_;
+    std::vector<std::size_t> histograms_;
+
+public:
+    using value_type = T;
+
+    /**
+     *  @brief Sort "size" elements starting at "data" in ascending order.
+    */
+    void Sort(T* data, std::size_t size) {
+        if (size < 2) return;
+        if (scratch_.size() < size) {
+            scratch_.resize(size);
+        }
+        RadixSortItems<T, _DigitBits>(data, scratch_.data(), size, histograms_, [](T value) { return value; });
+    }
+
+    void Sort(std::vector<T>& values) {
+        Sort(values.data(), values.size());
+    }
+
+    /**
+     *  @brief Free the scratch buffer.
+    */
+    void ShrinkToFit() {
+        scratch_ = std::vector<T>();
+        histograms_ = std::vector<std::size_t>();
+    }
+};
+
+/**
+ *  @brief Sort "values" by RadixSorter with a scratch buffer allocated for this call.
+*/
+template<typename T, unsigned _DigitBits = 8>
+inline void RadixSort(std::vector<T>& values) {
+    RadixSorter<T, _DigitBits>().Sort(values);
+}
+
+/**
+ *  @brief Sort "nums" by counting sort when the value range is narrow and by LSD radix sort otherwise
+ *  The first pass finds min and max with simd::MinMax. Counting sort is used while (hi - lo + 1) is at most
+ *  counting_sort_range_per_element * n and at most counting_sort_max_range, so a single outlier can not make it
+ *  allocate or scan a huge catalog. Wider ranges go through RadixSort, O(n) regardless of the values.
+ *  Extra memory is at most min(2 * n, counting_sort_max_range) counters or n keys.
+*/
+inline void HybridSort(std::vector<int>& nums) {
+    const std::size_t size = nums.size();
+    if (size < 2) return;
+    const auto [lo, hi] = simd::MinMax(nums.data(), size);
+    if (lo == hi) return;
+
+    const std::size_t range = static_cast<std::size_t>(static_cast<std::int64_t>(hi) - lo) + 1;
+    if (range <= counting_sort_range_per_element * size && range <= counting_sort_max_range) {
+        CountingSortRange(nums.data(), size, lo, range);
+    } else {
+        RadixSort(nums);
+    }
+}
+
+/**
+ *  @brief Arrays smaller than this are sorted on the calling thread by the parallel sorts.
+*/
+constexpr std::size_t parallel_sort_min_size = std::size_t(1) << 17;
+
+/**
+ *  @brief Returns count of hardware threads, 1 if it is unknown.
+*/
+inline std::size_t GetHardwareThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+namespace {
+// Reusable barrier for a fixed count of threads.
+class ThreadBarrier {
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::size_t count_;
+    std::size_t waiting_ = 0;
+    std::size_t generation_ = 0;
+
+public:
+    explicit ThreadBarrier(std::size_t count) : count_(count) {}
+
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const std::size_t generation = generation_;
+        if (++waiting_ == count_) {
+            waiting_ = 0;
+            ++generation_;
+            condition_.notify_all();
+            return;
+        }
+        condition_.wait(lock, [this, generation]() { return generation != generation_; });
+    }
+};
+
+// Run "func(thread_index, barrier)" on "thread_count" threads, the calling thread is index 0.
+// Workers call "func" only once all of them are started. If starting one throws, the started ones return without
+// calling it, they are joined and the exception is rethrown, so nothing ran. "func" must not throw, the other
+// threads would wait at the barrier forever.
+template<typename Func>
+inline void RunWorkers(std::size_t thread_count, Func&& func) {
+    enum class StartState { Waiting, Run, Cancel };
+    ThreadBarrier barrier(thread_count);
+    std::mutex start_mutex;
+    std::condition_variable start_condition;
+    StartState start = StartState::Waiting;
+    auto set_start = [&](StartState state) {
+        {
+            std::lock_guard<std::mutex> lock(start_mutex);
+            start = state;
+        }
+        start_condition.notify_all();
+    };
+
+    std::vector<std::thread> threads;
+    try {
+        threads.reserve(thread_count - 1);
+        for (std::size_t t = 1; t < thread_count; ++t) {
+            threads.emplace_back([&, t]() {
+                {
+                    std::unique_lock<std::mutex> lock(start_mutex);
+                    start_condition.wait(lock, [&start]() { return start != StartState::Waiting; });
+                    if (start == StartState::Cancel) return;
+                }
+                func(t, barrier);
+            });
+        }
+    } catch (...) {
+        set_start(StartState::Cancel);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        throw;
+    }
+    set_start(StartState::Run);
+    func(0, barrier);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// Part [first, last) of "size" elements handled by thread "t" of "thread_count".
+inline std::pair<std::size_t, std::size_t> GetChunk(std::size_t size, std::size_t thread_count, std::size_t t) {
+    return {size * t / thread_count, size * (t + 1) / thread_count};
+}
+}
+
+/**
+ *  @brief LSD radix sort on several threads
+ *  The array is split in one contiguous chunk per thread. For every digit each thread counts its chunk into its
+ *  own histogram, one thread turns all histograms into scatter offsets with a prefix sum ordered by bucket and
+ *  then by thread, and every thread scatters its chunk. Each chunk keeps its relative order in every bucket,
+ *  so the sort stays stable and the result is the same as RadixSorter's. Passes where every key has the same
+ *  digit are skipped. Arrays below "min_parallel_size" and sorters with one thread use RadixSorter.
+ *  If a thread can not be started, std::system_error is thrown and the array is unchanged.
+ *  @tparam T Key type
+ *  @tparam DigitBits Bits per pass
+*/
+template<typename T, unsigned _DigitBits = 8>
+class ParallelRadixSorter {
+    using Digits = RadixDigits<T, _DigitBits>;
+
+    static constexpr unsigned pass_count = Digits::pass_count;
+    static constexpr std::size_t bucket_count = Digits::bucket_count;
+
+    std::size_t thread_count_;
+    std::size_t min_parallel_size_;
+    RadixSorter<T, _DigitBits> sequential_;
+    std::vector<T> scratch_;
+    std::vector<std::size_t> histograms_;
+    std::vector<std::uint32_t> sub_histograms_;
+    unsigned scattered_passes_ = 0;
+
+public:
+    using value_type = T;
+
+    explicit ParallelRadixSorter(std::size_t thread_count = GetHardwareThreadCount(),
+                                 std::size_t min_parallel_size = parallel_sort_min_size)
+        : thread_count_(std::max<std::size_t>(1, thread_count)), min_parallel_size_(min_parallel_size) {}
+
+    /**
+     *  @brief Sort "size" elements starting at "data" in ascending order.
+    */
+    void Sort(T* data, std::size_t size) {
+        const std::size_t thread_count = std::min(thread_count_, size);
+        if (thread_count < 2 || size < min_parallel_size_) {
+            sequential_.Sort(data, size);
+            return;
+        }
+        if (scratch_.size() < size) {
+            scratch_.resize(size);
+        }
+        histograms_.assign(thread_count * bucket_count, 0);
+        // Workers must not allocate, an exception in one would leave the others at the barrier
+        constexpr std::size_t sub_histogram_size = GetHistogramScratchSize(bucket_count);
+        sub_histograms_.resize(thread_count * sub_histogram_size);
+        T* const scratch = scratch_.data();
+        std::size_t* const histograms = histograms_.data();
+        std::uint32_t* const sub_histograms = sub_histograms_.data();
+        bool skip = false;
+        scattered_passes_ = 0;
+
+        RunWorkers(thread_count, [&](std::size_t t, ThreadBarrier& barrier) {
+            const auto [first, last] = GetChunk(size, thread_count, t);
+            std::size_t* const offsets = histograms + t * bucket_count;
+            std::uint32_t* const own_sub_histograms = sub_histograms + t * sub_histogram_size;
+            T* from = data;
+            T* to = scratch;
+            for (unsigned pass = 0; pass < pass_count; ++pass) {
+                BuildHistogram(from + first, last - first, bucket_count, offsets, own_sub_histograms,
+                               [pass](T value) { return Digits::GetDigit(value, pass); });
+                barrier.Wait();
+
+                if (t == 0) {
+                    skip = false;
+                    std::size_t sum = 0;
+                    for (std::size_t bucket = 0; bucket < bucket_count; ++bucket) {
+                        std::size_t bucket_total = 0;
+                        for (std::size_t other = 0; other < thread_count; ++other) {
+                            std::size_t& offset = histograms[other * bucket_count + bucket];
+                            const std::size_t count = offset;
+                            bucket_total += count;
+                            offset = sum;
+                            sum += count;
+                        }
+                        skip = skip || bucket_total == size;
+                    }
+                    scattered_passes_ += skip ? 0 : 1;
+                }
+                barrier.Wait();
+
+                if (!skip) {
+                    for (std::size_t i = first; i < last; ++i) {
+                        to[offsets[Digits::GetDigit(from[i], pass)]++] = from[i];
+                    }
+                    std::swap(from, to);
+                }
+                barrier.Wait();
+            }
+            if (from != data) {
+                std::copy(from + first, from + last, data + first);
+            }
+        });
+    }
+
+    void Sort(std::vector<T>& values) {
+        Sort(values.data(), values.size());
+    }
+
+    /**
+     *  @brief Returns the count of threads a large array is sorted on.
+    */
+    inline std::size_t ThreadCount() const {
+        return thread_count_;
+    }
+
+    /**
+     *  @brief Returns the count of digit passes the last parallel Sort scattered, the others were skipped.
+    */
+    inline unsigned ScatteredPassCount() const {
+        return scattered_passes_;
+    }
+};
+
+/**
+ *  @brief HybridSort on several threads
+ *  Min and max are found in parallel. A narrow range is sorted by counting sort: each thread counts its chunk
+ *  into its own catalog, the catalogs are summed and written back by value ranges, one per thread. Counting sort
+ *  is used under the same conditions as in HybridSort with the catalogs of all threads limited to
+ *  counting_sort_max_range together, wider ranges go through ParallelRadixSorter.
+ *  Arrays below "min_parallel_size" and one thread use HybridSort. If a thread can not be started,
+ *  std::system_error is thrown and the array is unchanged.
+*/
+inline void ParallelHybridSort(std::vector<int>& nums, std::size_t thread_count = GetHardwareThreadCount(),
+                               std::size_t min_parallel_size = parallel_sort_min_size) {
+    const std::size_t size = nums.size();
+    thread_count = std::min(std::max<std::size_t>(1, thread_count), size);
+    if (thread_count < 2 || size < min_parallel_size) {
+        HybridSort(nums);
+        return;
+    }
+    int* const data = nums.data();
+
+    std::vector<std::pair<int, int>> bounds(thread_count);
+    RunWorkers(thread_count, [&](std::size_t t, ThreadBarrier&) {
+        const auto [first, last] = GetChunk(size, thread_count, t);
+        bounds[t] = simd::MinMax(data + first, last - first);
+    });
+    int lo = bounds[0].first;
+    int hi = bounds[0].second;
+    for (const auto& [chunk_lo, chunk_hi] : bounds) {
+        lo = std::min(lo, chunk_lo);
+        hi = std::max(hi, chunk_hi);
+    }
+    if (lo == hi) return;
+
+    const std::size_t range = static_cast<std::size_t>(static_cast<std::int64_t>(hi) - lo) + 1;
+    if (range > counting_sort_range_per_element * size || range * thread_count > counting_sort_max_range) {
+        ParallelRadixSorter<int>(thread_count, min_parallel_size).Sort(nums);
+        return;
+    }
+
+    std::vector<std::size_t> counts(range * thread_count);
+    std::vector<std::size_t> value_totals(thread_count, 0);
+    const std::size_t sub_histogram_size = GetHistogramScratchSize(range);
+    std::vector<std::uint32_t> sub_histograms(thread_count * sub_histogram_size);
+    RunWorkers(thread_count, [&](std::size_t t, ThreadBarrier& barrier) {
+        const auto [first, last] = GetChunk(size, thread_count, t);
+        BuildHistogram(data + first, last - first, range, counts.data() + t * range,
+                       sub_histograms.data() + t * sub_histogram_size, [lo](int value) {
+            return static_cast<std::size_t>(static_cast<std::int64_t>(value) - lo);
+        });
+        barrier.Wait();
+
+        // Sum the catalogs of all threads into the first one, each thread sums its own range of values
+        const auto [value_first, value_last] = GetChunk(range, thread_count, t);
+        std::size_t total = 0;
+        for (std::size_t k = value_first; k < value_last; ++k) {
+            std::size_t count = counts[k];
+            for (std::size_t other = 1; other < thread_count; ++other) {
+                count += counts[other * range + k];
+            }
+            counts[k] = count;
+            total += count;
+        }
+        value_totals[t] = total;
+        barrier.Wait();
+
+        std::size_t start = 0;
+        for (std::size_t other = 0; other < t; ++other) {
+            start += value_totals[other];
+        }
+        int* out = data + start;
+        for (std::size_t k = value_first; k < value_last; ++k) {
+            out = std::fill_n(out, counts[k], static_cast<int>(lo + static_cast<std::int64_t>(k)));
+        }
+    });
+}
+
+/**
+ *  @brief Records of at most this size that are trivially copyable are radix sorted directly by SortByKey,
+ *  larger ones are ordered through Argsort and moved once.
+*/
+constexpr std::size_t sort_by_key_direct_max_size = 32;
+
+namespace {
+// Key with the index of its record, sorted instead of the records themselves.
+template<typename K>
+struct KeyIndex {
+    K key;
+    std::size_t index;
+};
+
+template<typename Record, typename KeyFunc>
+using sort_key_t = std::decay_t<std::invoke_result_t<KeyFunc&, const Record&>>;
+}
+
+/**
+ *  @brief Returns the stable sorting permutation of "records" by "key(record)"
+ *  Element i of the result is the index of the record that goes to position i, records with equal keys keep their
+ *  order. Only (key, index) pairs are radix sorted, the records are not moved.
+ *  @param key Returns an integer or floating point key of a record
+*/
+template<typename Record, typename KeyFunc>
+inline std::vector<std::size_t> Argsort(const std::vector<Record>& records, KeyFunc key) {
+    using K = sort_key_t<Record, KeyFunc>;
+    const std::size_t size = records.size();
+    std::vector<KeyIndex<K>> items(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        items[i] = {key(records[i]), i};
+    }
+    if (size > 1) {
+        std::vector<KeyIndex<K>> scratch(size);
+        std::vector<std::size_t> histograms;
+        RadixSortItems<K, 8>(items.data(), scratch.data(), size, histograms,
+                             [](const KeyIndex<K>& item) { return item.key; });
+    }
+    std::vector<std::size_t> permutation(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        permutation[i] = items[i].index;
+    }
+    return permutation;
+}
+
+/**
+ *  @brief Reorder "records" so that position i holds the record that was at "permutation[i]"
+ *  Follows the cycles of the permutation, each record is moved once plus one move per cycle, no second array of
+ *  records is allocated. "permutation" is consumed.
+*/
+template<typename Record>
+inline void ApplyPermutation(std::vector<Record>& records, std::vector<std::size_t>& permutation) {
+    for (std::size_t start = 0; start < records.size(); ++start) {
+        if (permutation[start] == start) continue;
+        Record cycle_front = std::move(records[start]);
+        std::size_t position = start;
+        while (true) {
+            const std::size_t source = permutation[position];
+            permutation[position] = position;
+            if (source == start) {
+                records[position] = std::move(cycle_front);
+                break;
+            }
+            records[position] = std::move(records[source]);
+            position = source;
+        }
+    }
+}
+
+/**
+ *  @brief Stable sort of "records" by "key(record)"
+ *  Small trivially copyable records are radix sorted directly, one scatter per non-uniform key digit. Larger
+ *  records are ordered by Argsort and moved to their place once by ApplyPermutation, so a payload is never moved
+ *  per digit.
+ *  @param key Returns an integer or floating point key of a record
+*/
+template<typename Record, typename KeyFunc>
+inline void SortByKey(std::vector<Record>& records, KeyFunc key) {
+    using K = sort_key_t<Record, KeyFunc>;
+    if (records.size() < 2) return;
+    if constexpr (sizeof(Record) <= sort_by_key_direct_max_size && std::is_trivially_copyable_v<Record>
+                  && std::is_default_constructible_v<Record>) {
+        std::vector<Record> scratch(records.size());
+        std::vector<std::size_t> histograms;
+        RadixSortItems<K, 8>(records.data(), scratch.data(), records.size(), histograms,
+                             [&key](const Record& record) { return key(record); });
+    } else {
+        std::vector<std::size_t> permutation = Argsort(records, key);
+        ApplyPermutation(records, permutation);
+    }
+}
@@ -7,7 +7,29 @@
 #include <iostream>
 #include <chrono>
 #include <variant>
+#include <thread>
+#include <mutex>
+#include <memory_resource>
+#include <string>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <limits>
+#include <cmath>
+#include <filesystem>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #include "CircularBuffer.h"
+#include "MappedCircularBuffer.h"
+#include "SharedCircularBuffer.h"
+#include "SlidingWindow.h"
+#include "CircularBufferSimd.h"
+#include "TimeWindow.h"
+#include "Sort.h"
 #include "Tests.h"
 
 #define ASSERT_MESSAGE(condition, message)                                      \
@@ -919,82 +941,3192 @@ void CircBufferIteration() {
         }
     }
 }
-void CircBufferTimeTest() {
-    auto StackAllocator_128 = []()
+void CircBufferIterationWrapped() {
+    std::vector<int> vec = {4, 5, 6, 7, 8};
+    //StackAllocator
+    {
+        CircularBufferArray<int, 5> a = {1, 2, 3};
+        a.PushBack(4);
+        a.PushBack(5);
+        a.PushBack(6);
+        a.PushBack(7);
+        a.PushBack(8);
+        auto it_vec = vec.begin();
+        for (int i : a) {
+            ASSERT(*it_vec == i);
+            it_vec++;
+        }
+        ASSERT(it_vec == vec.end());
+    }
+    //HeapAllocator
+    {
+        CircularBufferArray<int, 5, int> a = {1, 2, 3};
+        a.PushBack(4);
+        a.PushBack(5);
+        a.PushBack(6);
+        a.PushBack(7);
+        a.PushBack(8);
+        auto it_vec = vec.begin();
+        for (int i : a) {
+            ASSERT(*it_vec == i);
+            it_vec++;
+        }
+        ASSERT(it_vec == vec.end());
+    }
+}
+void CircBufferPowerOfTwoCapacity() {
+    auto check = [](auto& a) {
+        const int capacity = static_cast<int>(a.Capacity());
+        const int count = capacity * 3 + 3;
+        for (int i = 0; i < count; ++i) {
+            a.PushBack(i);
+        }
+        ASSERT(a.IsFull());
+        ASSERT(a.GetFront() == count - capacity);
+        ASSERT(a.GetBack() == count - 1);
+        for (int i = 0; i < capacity; ++i) {
+            ASSERT(a[i] == count - capacity + i);
+        }
+        int expected = count - capacity;
+        for (int i : a) {
+            ASSERT(i == expected);
+            ++expected;
+        }
+        a.PopFront();
+        a.PopBack();
+        ASSERT(a.Size() == static_cast<size_t>(capacity - 2));
+        ASSERT(a.GetFront() == count - capacity + 1);
+        ASSERT(a.GetBack() == count - 2);
+        a.Clear();
+        ASSERT(a.IsEmpty());
+        a.PushBack(42);
+        ASSERT(a[0] == 42);
+    };
+    //StackAllocator
+    {
+        CircularBufferArray<int, 8> a;
+        check(a);
+        CircularBufferArray<int, 7> b;
+        check(b);
+    }
+    //HeapAllocator
+    {
+        CircularBufferArray<int, 2048> a;
+        check(a);
+        CircularBufferArray<int, 2047> b;
+        check(b);
+    }
+    //HeapAllocator
     {
-        CircularBufferArray<int, 128> a;
-        for (int i = 0; i < 100000; ++i) {
-            for (int j = 0; j < 128; ++j) {
-                a.EmplaceBack(j);
+        CircularBufferArray<int, 8, int> a;
+        check(a);
+        CircularBufferArray<int, 7, int> b;
+        check(b);
+    }
+}
+void SpscBufferTryPushTryPop() {
+    auto check = [](auto& a) {
+        const int capacity = static_cast<int>(a.Capacity());
+        int value = -1;
+        ASSERT(a.IsEmpty());
+        ASSERT(!a.TryPop(value));
+        ASSERT(value == -1);
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < capacity; ++i) {
+                ASSERT(a.TryPush(round * capacity + i));
+            }
+            ASSERT(a.IsFull());
+            ASSERT(a.Size() == static_cast<size_t>(capacity));
+            ASSERT(!a.TryPush(-1));
+            for (int i = 0; i < capacity; ++i) {
+                ASSERT(a.TryPop(value));
+                ASSERT(value == round * capacity + i);
             }
+            ASSERT(a.IsEmpty());
+            ASSERT(!a.TryPop(value));
+        }
+        // Keep the buffer half full while positions go around several times
+        for (int i = 0; i < capacity / 2; ++i) {
+            ASSERT(a.TryEmplace(i));
+        }
+        for (int i = capacity / 2; i < capacity * 5; ++i) {
+            ASSERT(a.TryPush(i));
+            ASSERT(a.TryPop(value));
+            ASSERT(value == i - capacity / 2);
         }
     };
-    auto HeapAllocator_128 = []()
+    //StackAllocator
+    {
+        SpscCircularBufferArray<int, 5> a;
+        check(a);
+        SpscCircularBufferArray<int, 8> b;
+        check(b);
+    }
+    //HeapAllocator
+    {
+        SpscCircularBufferArray<int, 5000> a;
+        check(a);
+        SpscCircularBufferArray<int, 4096> b;
+        check(b);
+    }
+    //HeapAllocator
     {
-        CircularBufferArray<int, 128, int> a;
-        for (int i = 0; i < 100000; ++i) {
-            for (int j = 0; j < 128; ++j) {
-                a.EmplaceBack(j);
+        SpscCircularBufferArray<int, 5, int> a;
+        check(a);
+        SpscCircularBufferArray<int, 8, int> b;
+        check(b);
+    }
+}
+void SpscBufferTwoThreads() {
+    auto check = [](auto& a) {
+        const int count = 100000;
+        std::thread producer([&a]() {
+            for (int i = 0; i < count; ++i) {
+                while (!a.TryPush(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        bool in_order = true;
+        for (int i = 0; i < count; ++i) {
+            int value;
+            while (!a.TryPop(value)) {
+                std::this_thread::yield();
             }
+            in_order = in_order && value == i;
         }
+        producer.join();
+        ASSERT(in_order);
+        ASSERT(a.IsEmpty());
     };
-    auto StackAllocator_1024 = []()
+    //StackAllocator
+    {
+        SpscCircularBufferArray<int, 100> a;
+        check(a);
+    }
+    //HeapAllocator
+    {
+        SpscCircularBufferArray<int, 1024, int> a;
+        check(a);
+    }
+}
+void SpscBufferTimeTest() {
+    constexpr int count = 1000000;
+
+    auto Spsc_Throughput_1024 = []()
     {
-        CircularBufferArray<int, 1024> a;
-        for (int i = 0; i < 100000; ++i) {
-            for (int j = 0; j < 1024; ++j) {
-                a.EmplaceBack(j);
+        SpscCircularBufferArray<int, 1024, int> a;
+        std::thread producer([&a]() {
+            for (int i = 0; i < count; ++i) {
+                while (!a.TryPush(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        int value;
+        for (int i = 0; i < count; ++i) {
+            while (!a.TryPop(value)) {
+                std::this_thread::yield();
             }
         }
+        producer.join();
     };
-    auto HeapAllocatorMax_1025 = []()
+    auto Spsc_Throughput_1000 = []()
     {
-        CircularBufferArray<int, 1025> a;
-        for (int i = 0; i < 100000; ++i) {
-            for (int j = 0; j < 1025; ++j) {
-                a.EmplaceBack(j);
+        SpscCircularBufferArray<int, 1000, int> a;
+        std::thread producer([&a]() {
+            for (int i = 0; i < count; ++i) {
+                while (!a.TryPush(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        int value;
+        for (int i = 0; i < count; ++i) {
+            while (!a.TryPop(value)) {
+                std::this_thread::yield();
             }
         }
+        producer.join();
     };
-    auto HeapAllocator_1024 = []()
+    auto Mutex_Throughput_1024 = []()
     {
         CircularBufferArray<int, 1024, int> a;
-        for (int i = 0; i < 100000; ++i) {
-            for (int j = 0; j < 1024; ++j) {
-                a.EmplaceBack(j);
+        std::mutex mutex;
+        std::thread producer([&a, &mutex]() {
+            for (int i = 0; i < count; ++i) {
+                while (true) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!a.IsFull()) {
+                            a.PushBack(i);
+                            break;
+                        }
+                    }
+                    std::this_thread::yield();
+                }
+            }
+        });
+        for (int i = 0; i < count; ++i) {
+            while (true) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!a.IsEmpty()) {
+                        a.ReleaseFront();
+                        break;
+                    }
+                }
+                std::this_thread::yield();
             }
         }
+        producer.join();
     };
 
-    struct LageDataStruct {
-        std::variant<double, int> a, b, c, d, f, g, h, i;
+    // Ping-pong between two threads, one round trip is two handoffs.
+    auto Spsc_Latency = []()
+    {
+        constexpr int round_trips = 100000;
+        SpscCircularBufferArray<int, 64, int> ping;
+        SpscCircularBufferArray<int, 64, int> pong;
+        std::thread echo([&ping, &pong]() {
+            int value;
+            for (int i = 0; i < round_trips; ++i) {
+                while (!ping.TryPop(value)) {
+                    std::this_thread::yield();
+                }
+                while (!pong.TryPush(value)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        auto start = std::chrono::steady_clock::now();
+        int value;
+        for (int i = 0; i < round_trips; ++i) {
+            while (!ping.TryPush(i)) {
+                std::this_thread::yield();
+            }
+            while (!pong.TryPop(value)) {
+                std::this_thread::yield();
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        echo.join();
+        std::chrono::duration<double, std::nano> duration = end - start;
+        std::cout << "Latency of Spsc_Latency: " << duration.count() / round_trips / 2 << " ns per handoff" << std::endl;
+    };
+
+    TIME_DIF(Spsc_Throughput_1024)
+    TIME_DIF(Spsc_Throughput_1000)
+    TIME_DIF(Mutex_Throughput_1024)
+    TIME_DIF(Spsc_Latency)
+}
+void MpmcBufferTryPushTryPop() {
+    auto check = [](auto& a) {
+        const int capacity = static_cast<int>(a.Capacity());
+        int value = -1;
+        ASSERT(a.IsEmpty());
+        ASSERT(!a.TryPop(value));
+        ASSERT(value == -1);
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < capacity; ++i) {
+                ASSERT(a.TryPush(round * capacity + i));
+            }
+            ASSERT(a.IsFull());
+            ASSERT(!a.TryEmplace(-1));
+            for (int i = 0; i < capacity; ++i) {
+                ASSERT(a.TryPop(value));
+                ASSERT(value == round * capacity + i);
+            }
+            ASSERT(a.IsEmpty());
+        }
+        std::vector<int> input(capacity + 3);
+        for (int i = 0; i < capacity + 3; ++i) {
+            input[i] = i;
+        }
+        ASSERT(a.TryPushBatch(input.begin(), input.begin() + 2) == 2);
+        ASSERT(a.TryPushBatch(input.begin() + 2, input.end()) == static_cast<size_t>(capacity - 2));
+        ASSERT(a.TryPushBatch(input.begin(), input.end()) == 0);
+        std::vector<int> output;
+        ASSERT(a.TryPopBatch(std::back_inserter(output), 1) == 1);
+        ASSERT(a.TryPopBatch(std::back_inserter(output), capacity * 2) == static_cast<size_t>(capacity - 1));
+        ASSERT(a.TryPopBatch(std::back_inserter(output), 1) == 0);
+        for (int i = 0; i < capacity; ++i) {
+            ASSERT(output[i] == i);
+        }
+    };
+    //StackAllocator
+    {
+        MpmcCircularBufferArray<int, 5> a;
+        check(a);
+        MpmcCircularBufferArray<int, 8> b;
+        check(b);
+    }
+    //HeapAllocator
+    {
+        MpmcCircularBufferArray<int, 5000> a;
+        check(a);
+        MpmcCircularBufferArray<int, 4096> b;
+        check(b);
+    }
+    //HeapAllocator
+    {
+        MpmcCircularBufferArray<int, 5, int> a;
+        check(a);
+        MpmcCircularBufferArray<int, 8, int> b;
+        check(b);
+    }
+}
+void MpmcBufferThrowingElement() {
+    static int alive = 0;
+    struct Throwing {
+        int value = 0;
+        Throwing() { ++alive; }
+        Throwing(int v) : value(v) {
+            if (v < 0) throw std::runtime_error("negative");
+            ++alive;
+        }
+        Throwing(const Throwing& other) : value(other.value) { ++alive; }
+        Throwing& operator=(const Throwing&) = default;
+        ~Throwing() { --alive; }
+    };
+    auto throws = [](auto&& func) {
+        try {
+            func();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    {
+        MpmcCircularBufferArray<Throwing, 4> a;
+        Throwing value;
+        ASSERT(a.TryEmplace(1));
+        ASSERT(throws([&a]() { a.TryEmplace(-1); }));
+        ASSERT(a.TryEmplace(2));
+        ASSERT(a.TryPop(value) && value.value == 1);
+        ASSERT(a.TryPop(value) && value.value == 2);
+        ASSERT(!a.TryPop(value));
+        ASSERT(a.IsEmpty());
+
+        // The slots after a failed batch element are skipped too
+        const std::vector<int> input = {3, -1, 4};
+        ASSERT(throws([&]() { a.TryPushBatch(input.begin(), input.end()); }));
+        ASSERT(a.TryEmplace(5));
+        std::vector<Throwing> output;
+        ASSERT(a.TryPopBatch(std::back_inserter(output), 4) == 2);
+        ASSERT(output[0].value == 3 && output[1].value == 5);
+
+        // A batch of skipped slots only is claimed again up to the next element
+        ASSERT(throws([&a]() { a.TryEmplace(-1); }));
+        ASSERT(a.TryEmplace(6));
+        output.clear();
+        ASSERT(a.TryPopBatch(std::back_inserter(output), 1) == 1);
+        ASSERT(output[0].value == 6);
+
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < 4; ++i) {
+                ASSERT(a.TryEmplace(i));
+            }
+            ASSERT(!a.TryEmplace(9));
+            for (int i = 0; i < 4; ++i) {
+                ASSERT(a.TryPop(value) && value.value == i);
+            }
+        }
+
+        // Skipped slots left in the ring are not destroyed as elements
+        ASSERT(a.TryEmplace(7));
+        ASSERT(throws([&a]() { a.TryEmplace(-1); }));
+    }
+    ASSERT(alive == 0);
+}
+void MpmcBufferManyThreads() {
+    constexpr int producers_count = 3;
+    constexpr int consumers_count = 3;
+    constexpr int count_per_producer = 30000;
+    // Each value encodes producer and sequence number, every consumer must see each producer's values in order.
+    auto check = [](auto& a, bool batch) {
+        std::vector<std::vector<int>> popped(consumers_count);
+        std::atomic<int> remaining = producers_count * count_per_producer;
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers_count; ++p) {
+            threads.emplace_back([&a, p, batch]() {
+                std::vector<int> values(count_per_producer);
+                for (int i = 0; i < count_per_producer; ++i) {
+                    values[i] = p * count_per_producer + i;
+                }
+                auto it = values.begin();
+                while (it != values.end()) {
+                    size_t pushed = batch ? a.TryPushBatch(it, std::min(it + 7, values.end())) : a.TryPush(*it);
+                    it += pushed;
+                    if (pushed == 0) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (int c = 0; c < consumers_count; ++c) {
+            threads.emplace_back([&a, &popped, &remaining, c, batch]() {
+                while (remaining.load() > 0) {
+                    int value;
+                    size_t count = batch ? a.TryPopBatch(std::back_inserter(popped[c]), 5) : a.TryPop(value);
+                    if (count == 0) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    if (!batch) {
+                        popped[c].push_back(value);
+                    }
+                    remaining -= static_cast<int>(count);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        std::vector<int> seen(producers_count * count_per_producer, 0);
+        for (auto& values : popped) {
+            std::vector<int> last(producers_count, -1);
+            for (int value : values) {
+                ++seen[value];
+                int producer = value / count_per_producer;
+                ASSERT(last[producer] < value);
+                last[producer] = value;
+            }
+        }
+        for (int n : seen) {
+            ASSERT(n == 1);
+        }
+        ASSERT(a.IsEmpty());
+    };
+    //StackAllocator
+    {
+        MpmcCircularBufferArray<int, 100> a;
+        check(a, false);
+        check(a, true);
+    }
+    //HeapAllocator
+    {
+        MpmcCircularBufferArray<int, 1024, int> a;
+        check(a, false);
+        check(a, true);
+    }
+}
+void MpmcBufferTimeTest() {
+    constexpr size_t total = 400000;
+    const size_t max_threads = std::max<size_t>(2, std::thread::hardware_concurrency());
+
+    auto run = [](auto& a, size_t producers_count, size_t consumers_count, size_t batch) {
+        std::atomic<size_t> remaining = total;
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t p = 0; p < producers_count; ++p) {
+            size_t count = total / producers_count + (p < total % producers_count ? 1 : 0);
+            threads.emplace_back([&a, count, batch]() {
+                std::vector<int> values(batch, 1);
+                size_t pushed = 0;
+                while (pushed < count) {
+                    size_t n = batch == 1 ? a.TryPush(1)
+                                          : a.TryPushBatch(values.begin(), values.begin() + std::min(batch, count - pushed));
+                    pushed += n;
+                    if (n == 0) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (size_t c = 0; c < consumers_count; ++c) {
+            threads.emplace_back([&a, &remaining, batch]() {
+                std::vector<int> values(batch);
+                int value;
+                while (remaining.load(std::memory_order_relaxed) > 0) {
+                    size_t n = batch == 1 ? a.TryPop(value) : a.TryPopBatch(values.begin(), batch);
+                    if (n == 0) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    remaining.fetch_sub(n, std::memory_order_relaxed);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        return total / duration.count();
     };
 
-    auto StackAllocator_LageDataStruct_32 = []()
+    for (size_t batch : {size_t(1), size_t(16)}) {
+        for (size_t producers_count = 1; producers_count <= max_threads; producers_count *= 2) {
+            for (size_t consumers_count = 1; consumers_count <= max_threads; consumers_count *= 2) {
+                MpmcCircularBufferArray<int, 1024, int> a;
+                double ops = run(a, producers_count, consumers_count, batch);
+                std::cout << "Mpmc_Scaling batch=" << batch << " producers=" << producers_count
+                          << " consumers=" << consumers_count << ": " << ops << " ops/sec" << std::endl;
+            }
+        }
+    }
+}
+namespace {
+// Counts copies and moves, "NothrowMove" selects whether relocation may move it.
+template<bool NothrowMove>
+struct RelocationCounter {
+    static inline int copies = 0;
+    static inline int moves = 0;
+    int value = 0;
+
+    RelocationCounter(int value) : value(value) {}
+    RelocationCounter(const RelocationCounter& other) : value(other.value) { ++copies; }
+    RelocationCounter(RelocationCounter&& other) noexcept(NothrowMove) : value(other.value) { ++moves; }
+    RelocationCounter& operator=(const RelocationCounter& other) = default;
+    RelocationCounter& operator=(RelocationCounter&& other) = default;
+
+    static void Reset() {
+        copies = 0;
+        moves = 0;
+    }
+};
+}
+
+void RuntimeCircBufferConstruct() {
+    {
+        CircularBuffer<int> a;
+        ASSERT(a.Capacity() == 0);
+        ASSERT(a.Size() == 0);
+        ASSERT(a.IsEmpty());
+    }
+    {
+        CircularBuffer<int> a(50);
+        ASSERT(a.Capacity() == 50);
+        ASSERT(a.Size() == 0);
+        ASSERT(a.IsEmpty());
+    }
+    {
+        CircularBuffer<int> a(5, 7);
+        ASSERT(a.Capacity() == 5);
+        ASSERT(a.IsFull());
+        for (int i : a) {
+            ASSERT(i == 7);
+        }
+    }
+    {
+        std::vector<int> vec = {1, 2, 3, 4, 5};
+        CircularBuffer<int> a(vec.begin(), vec.end());
+        ASSERT(a.Capacity() == 5);
+        for (size_t i = 0; i < vec.size(); ++i) {
+            ASSERT(vec[i] == a[i]);
+        }
+    }
+    {
+        CircularBuffer<int> a = {1, 2, 3, 4, 5};
+        CircularBuffer<int> b = a;
+        CircularBuffer<int> c = std::move(a);
+        ASSERT(a.Capacity() == 0);
+        ASSERT(b.Size() == 5);
+        ASSERT(c.Size() == 5);
+        for (size_t i = 0; i < 5; ++i) {
+            ASSERT(b[i] == static_cast<int>(i) + 1);
+            ASSERT(c[i] == static_cast<int>(i) + 1);
+        }
+        a = b;
+        b = std::move(c);
+        ASSERT(a.Size() == 5);
+        ASSERT(b.Size() == 5);
+        ASSERT(a[4] == 5);
+        ASSERT(b[4] == 5);
+    }
+}
+void RuntimeCircBufferMethods() {
+    CircularBuffer<int> a(5);
+    for (int i = 1; i <= 8; ++i) {
+        a.PushBack(i);
+    }
+    ASSERT(a.IsFull());
+    ASSERT(a.GetFront() == 4);
+    ASSERT(a.GetBack() == 8);
+    ASSERT(a[0] == 4);
+    ASSERT(a[4] == 8);
+    int expected = 4;
+    for (int i : a) {
+        ASSERT(i == expected);
+        ++expected;
+    }
+    ASSERT(a.ReleaseFront() == 4);
+    ASSERT(a.ReleaseBack() == 8);
+    ASSERT(a.Size() == 3);
+    a.PopFront();
+    a.PopBack();
+    ASSERT(a.Size() == 1);
+    ASSERT(a.GetFront() == 6);
+    a.Clear();
+    ASSERT(a.IsEmpty());
+    ASSERT(a.Capacity() == 5);
+    a.EmplaceBack(9);
+    ASSERT(a[0] == 9);
+}
+void RuntimeCircBufferReserve() {
+    //Trivially copyable
+    {
+        CircularBuffer<int> a(4);
+        for (int i = 1; i <= 6; ++i) {
+            a.PushBack(i);
+        }
+        a.Reserve(2);
+        ASSERT(a.Capacity() == 4);
+        a.Reserve(8);
+        ASSERT(a.Capacity() == 8);
+        ASSERT(a.Size() == 4);
+        for (size_t i = 0; i < 4; ++i) {
+            ASSERT(a[i] == static_cast<int>(i) + 3);
+        }
+        a.PushBack(7);
+        ASSERT(a.GetBack() == 7);
+        ASSERT(a.GetFront() == 3);
+    }
+    //Nothrow movable, relocation must move
+    {
+        using Counter = RelocationCounter<true>;
+        CircularBuffer<Counter> a(4);
+        for (int i = 1; i <= 6; ++i) {
+            a.EmplaceBack(i);
+        }
+        Counter::Reset();
+        a.Reserve(16);
+        ASSERT(Counter::copies == 0);
+        ASSERT(Counter::moves == 4);
+        for (size_t i = 0; i < 4; ++i) {
+            ASSERT(a[i].value == static_cast<int>(i) + 3);
+        }
+    }
+    //Throwing move, relocation must copy
+    {
+        using Counter = RelocationCounter<false>;
+        CircularBuffer<Counter> a(4);
+        for (int i = 1; i <= 6; ++i) {
+            a.EmplaceBack(i);
+        }
+        Counter::Reset();
+        a.Reserve(16);
+        ASSERT(Counter::copies == 4);
+        ASSERT(Counter::moves == 0);
+        for (size_t i = 0; i < 4; ++i) {
+            ASSERT(a[i].value == static_cast<int>(i) + 3);
+        }
+    }
+}
+void RuntimeCircBufferResize() {
+    CircularBuffer<std::vector<int>> a(3);
+    a.PushBack({1});
+    a.PushBack({2});
+    a.PushBack({3});
+    a.PushBack({4});
+    a.Resize(5, {0});
+    ASSERT(a.Capacity() == 5);
+    ASSERT(a.Size() == 5);
+    ASSERT(a[0][0] == 2);
+    ASSERT(a[2][0] == 4);
+    ASSERT(a[4][0] == 0);
+    a.Resize(2);
+    ASSERT(a.Size() == 2);
+    ASSERT(a.Capacity() == 5);
+    ASSERT(a.GetBack()[0] == 3);
+}
+void RuntimeCircBufferShrinkToFit() {
+    CircularBuffer<std::vector<int>> a(8);
+    for (int i = 0; i < 11; ++i) {
+        a.PushBack({i});
+    }
+    a.PopFront();
+    a.PopFront();
+    a.ShrinkToFit();
+    ASSERT(a.Capacity() == 6);
+    ASSERT(a.IsFull());
+    for (size_t i = 0; i < 6; ++i) {
+        ASSERT(a[i][0] == static_cast<int>(i) + 5);
+    }
+    a.Clear();
+    a.ShrinkToFit();
+    ASSERT(a.Capacity() == 0);
+    a.Reserve(1);
+    a.PushBack({42});
+    ASSERT(a.GetFront()[0] == 42);
+}
+namespace {
+// Stateful allocator without select_on_container_copy_construction, copies of containers keep it.
+template<typename T>
+struct TaggedAllocator {
+    using value_type = T;
+
+    int tag = 0;
+
+    explicit TaggedAllocator(int tag = 0) : tag(tag) {}
+
+    template<typename U>
+    TaggedAllocator(const TaggedAllocator<U>& other) : tag(other.tag) {}
+
+    T* allocate(size_t count) {
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* p, size_t count) {
+        std::allocator<T>().deallocate(p, count);
+    }
+
+    template<typename U>
+    bool operator==(const TaggedAllocator<U>& other) const {
+        return tag == other.tag;
+    }
+
+    template<typename U>
+    bool operator!=(const TaggedAllocator<U>& other) const {
+        return tag != other.tag;
+    }
+};
+
+// Memory resource counting allocations passed to the upstream resource.
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;
+    size_t deallocations = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        ++deallocations;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+}
+
+void CircBufferStandardAllocator() {
+    //std::allocator
+    {
+        CircularBufferArray<int, 5, std::allocator<int>> a = {1, 2, 3, 4, 5};
+        a.PushBack(6);
+        ASSERT(a.Size() == 5);
+        ASSERT(a[0] == 2);
+        ASSERT(a[4] == 6);
+    }
+    //std::pmr::polymorphic_allocator
     {
-        CircularBufferArray<LageDataStruct, 32> a;
-        for (int i = 0; i < 100000; ++i) {
-            for (int j = 0; j < 32; ++j) {
-                a.PushBack({j, j, j, j, j, j, j, j});
+        CountingResource resource;
+        {
+            pmr::CircularBufferArray<int, 5> a(std::allocator_arg, &resource);
+            ASSERT(resource.allocations == 1);
+            for (int i = 1; i <= 6; ++i) {
+                a.PushBack(i);
             }
+            ASSERT(a[0] == 2);
+            ASSERT(a[4] == 6);
+        }
+        ASSERT(resource.deallocations == 1);
+    }
+    //Concurrent containers
+    {
+        CountingResource resource;
+        {
+            pmr::SpscCircularBufferArray<int, 8> a(std::allocator_arg, &resource);
+            pmr::MpmcCircularBufferArray<int, 8> b(std::allocator_arg, &resource);
+            ASSERT(resource.allocations == 2);
+            int value;
+            ASSERT(a.TryPush(1) && a.TryPop(value) && value == 1);
+            ASSERT(b.TryPush(2) && b.TryPop(value) && value == 2);
+        }
+        ASSERT(resource.deallocations == 2);
+    }
+    //Monotonic resource
+    {
+        std::byte arena[1024];
+        std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena), std::pmr::null_memory_resource());
+        pmr::CircularBufferArray<int, 64> a(std::allocator_arg, &resource);
+        a.PushBack(1);
+        ASSERT(reinterpret_cast<std::byte*>(&a.GetFront()) >= arena);
+        ASSERT(reinterpret_cast<std::byte*>(&a.GetFront()) < arena + sizeof(arena));
+    }
+    //Elements use the container's resource
+    {
+        CountingResource resource;
+        {
+            pmr::CircularBufferArray<std::pmr::string, 2> a(std::allocator_arg, &resource);
+            for (int i = 0; i < 3; ++i) {
+                a.EmplaceBack("a long string that does not fit small string optimization " + std::to_string(i));
+            }
+            ASSERT(a.GetFront().get_allocator().resource() == &resource);
+            ASSERT(a.GetBack().get_allocator().resource() == &resource);
+            ASSERT(a.GetBack() == "a long string that does not fit small string optimization 2");
+            // Storage and one string per element, the overwriting one too
+            ASSERT(resource.allocations == 4);
+        }
+        ASSERT(resource.deallocations == resource.allocations);
+    }
+    //Copy selects the allocator as the standard containers do
+    {
+        CircularBufferArray<int, 4, TaggedAllocator<int>> a(std::allocator_arg, TaggedAllocator<int>(7));
+        a.PushBack(1);
+        CircularBufferArray<int, 4, TaggedAllocator<int>> b(a);
+        ASSERT(b.GetAllocator().tag == 7);
+        ASSERT(b.Size() == 1 && b[0] == 1);
+
+        // polymorphic_allocator selects the default resource for copies, as std::pmr::vector does
+        CountingResource resource;
+        CountingResource default_resource;
+        std::pmr::memory_resource* previous = std::pmr::set_default_resource(&default_resource);
+        {
+            pmr::CircularBufferArray<std::pmr::string, 4> c(std::allocator_arg, &resource);
+            c.PushBack("a long string that does not fit small string optimization");
+            pmr::CircularBufferArray<std::pmr::string, 4> d(c);
+            ASSERT(c.GetAllocator().resource() == &resource);
+            ASSERT(d.GetAllocator().resource() == &default_resource);
+            ASSERT(d.GetFront().get_allocator().resource() == &default_resource);
+            ASSERT(d.GetFront() == c.GetFront());
+            ASSERT(resource.allocations == 2);
+            ASSERT(default_resource.allocations == 2);
+        }
+        std::pmr::set_default_resource(previous);
+        ASSERT(resource.deallocations == 2);
+        ASSERT(default_resource.deallocations == 2);
+    }
+}
+void RuntimeCircBufferStandardAllocator() {
+    CountingResource resource;
+    CountingResource other_resource;
+    {
+        pmr::CircularBuffer<std::pmr::string> a(4, &resource);
+        ASSERT(resource.allocations == 1);
+        a.PushBack("a long string that does not fit small string optimization 1");
+        a.PushBack("a long string that does not fit small string optimization 2");
+        // Elements use the container's resource
+        ASSERT(a.GetBack().get_allocator().resource() == &resource);
+
+        pmr::CircularBuffer<std::pmr::string> b(a, &other_resource);
+        ASSERT(b.GetAllocator().resource() == &other_resource);
+        ASSERT(b.Size() == 2);
+        ASSERT(b.GetBack().get_allocator().resource() == &other_resource);
+
+        // Not propagating allocator keeps its resource on move assignment
+        pmr::CircularBuffer<std::pmr::string> c(1, &other_resource);
+        c = std::move(a);
+        ASSERT(c.GetAllocator().resource() == &other_resource);
+        ASSERT(c.Size() == 2);
+        ASSERT(c.Capacity() == 4);
+        ASSERT(c.GetFront() == "a long string that does not fit small string optimization 1");
+
+        c.Reserve(16);
+        ASSERT(c.GetBack() == "a long string that does not fit small string optimization 2");
+    }
+    ASSERT(resource.allocations == resource.deallocations);
+    ASSERT(other_resource.allocations == other_resource.deallocations);
+}
+void CircBufferAllocatorTimeTest() {
+    constexpr int buffers = 100000;
+
+    auto HeapAllocator_ShortLived_256 = []()
+    {
+        for (int i = 0; i < buffers; ++i) {
+            CircularBufferArray<int, 256, int> a;
+            a.EmplaceBack(i);
+        }
+    };
+    auto StdAllocator_ShortLived_256 = []()
+    {
+        for (int i = 0; i < buffers; ++i) {
+            CircularBufferArray<int, 256, std::allocator<int>> a;
+            a.EmplaceBack(i);
         }
     };
-    auto HeapAllocator_LageDataStruct_32 = []()
+    auto PmrMonotonic_ShortLived_256 = []()
     {
-        CircularBufferArray<LageDataStruct, 32, int> a;
-        for (int i = 0; i < 100000; ++i) {
-            for (int j = 0; j < 32; ++j) {
-                a.PushBack({j, j, j, j, j, j, j, j});
+        std::pmr::monotonic_buffer_resource resource;
+        for (int i = 0; i < buffers; ++i) {
+            pmr::CircularBufferArray<int, 256> a(std::allocator_arg, &resource);
+            a.EmplaceBack(i);
+            if (i % 1000 == 999) {
+                resource.release();
             }
         }
     };
+    auto PmrPool_ShortLived_256 = []()
+    {
+        std::pmr::unsynchronized_pool_resource resource;
+        for (int i = 0; i < buffers; ++i) {
+            pmr::CircularBufferArray<int, 256> a(std::allocator_arg, &resource);
+            a.EmplaceBack(i);
+        }
+    };
+    auto Runtime_StdAllocator_ShortLived_256 = []()
+    {
+        for (int i = 0; i < buffers; ++i) {
+            CircularBuffer<int> a(256);
+            a.EmplaceBack(i);
+        }
+    };
+    auto Runtime_PmrPool_ShortLived_256 = []()
+    {
+        std::pmr::unsynchronized_pool_resource resource;
+        for (int i = 0; i < buffers; ++i) {
+            pmr::CircularBuffer<int> a(256, &resource);
+            a.EmplaceBack(i);
+        }
+    };
 
+    TIME_DIF(HeapAllocator_ShortLived_256)
+    TIME_DIF(StdAllocator_ShortLived_256)
+    TIME_DIF(PmrMonotonic_ShortLived_256)
+    TIME_DIF(PmrPool_ShortLived_256)
+    TIME_DIF(Runtime_StdAllocator_ShortLived_256)
+    TIME_DIF(Runtime_PmrPool_ShortLived_256)
+}
+void CircBufferMethodPushBackRange() {
+    auto check = [](auto& a) {
+        using value_type = typename std::remove_reference_t<decltype(a)>::value_type;
+        const int capacity = static_cast<int>(a.Capacity());
+        std::vector<value_type> vec;
+        for (int i = 0; i < capacity * 2 + 3; ++i) {
+            vec.push_back(static_cast<value_type>(i));
+        }
+        a.PushBack(static_cast<value_type>(-1));
+        a.PushBackRange(vec.data(), 2);
+        ASSERT(a.Size() == 3);
+        ASSERT(a[0] == static_cast<value_type>(-1));
+        ASSERT(a[2] == static_cast<value_type>(1));
+        // Wraps around the end of the storage
+        a.PushBackRange(vec.data() + 2, static_cast<size_t>(capacity - 1));
+        ASSERT(a.IsFull());
+        for (int i = 0; i < capacity; ++i) {
+            ASSERT(a[i] == static_cast<value_type>(i + 1));
+        }
+        // Longer than capacity, only the last elements stay
+        a.PushBackRange(vec.data(), vec.size());
+        ASSERT(a.IsFull());
+        for (int i = 0; i < capacity; ++i) {
+            ASSERT(a[i] == vec[vec.size() - capacity + i]);
+        }
+        a.PopFront();
+        a.PushBackRange(vec.begin(), vec.begin() + 1);
+        ASSERT(a.GetBack() == vec[0]);
+        ASSERT(a.GetFront() == vec[vec.size() - capacity + 1]);
+        a.PushBack(static_cast<value_type>(7));
+        ASSERT(a.GetBack() == static_cast<value_type>(7));
+    };
+    //StackAllocator
+    {
+        CircularBufferArray<int, 5> a;
+        check(a);
+        CircularBufferArray<int, 8> b;
+        check(b);
+    }
+    //HeapAllocator
+    {
+        CircularBufferArray<int, 2000> a;
+        check(a);
+        CircularBufferArray<double, 2048> b;
+        check(b);
+    }
+    //HeapAllocator
+    {
+        CircularBufferArray<int, 5, int> a;
+        check(a);
+    }
+    //Not trivially copyable
+    {
+        std::vector<std::string> vec = {"a", "b", "c", "d", "e", "f", "g"};
+        CircularBufferArray<std::string, 5> a;
+        a.PushBackRange(vec.begin(), vec.end());
+        ASSERT(a.Size() == 5);
+        ASSERT(a[0] == "c");
+        a.PushBackRange(vec.data(), 1);
+        ASSERT(a[4] == "a");
+    }
+}
+void CircBufferMethodPopFrontInto() {
+    auto check = [](auto& a) {
+        const int capacity = static_cast<int>(a.Capacity());
+        for (int i = 0; i < capacity + 2; ++i) {
+            a.PushBack(i);
+        }
+        std::vector<int> out(capacity + 5, -1);
+        ASSERT(a.PopFrontInto(out.data(), 1) == 1);
+        ASSERT(out[0] == 2);
+        ASSERT(a.Size() == static_cast<size_t>(capacity - 1));
+        // Wrapped contents
+        ASSERT(a.PopFrontInto(out.data() + 1, out.size()) == static_cast<size_t>(capacity - 1));
+        ASSERT(a.IsEmpty());
+        for (int i = 0; i < capacity; ++i) {
+            ASSERT(out[i] == i + 2);
+        }
+        ASSERT(out[capacity] == -1);
+        ASSERT(a.PopFrontInto(out.data(), 3) == 0);
+        a.PushBack(10);
+        a.PushBack(11);
+        std::vector<int> back;
+        ASSERT(a.PopFrontInto(std::back_inserter(back), 5) == 2);
+        ASSERT(back.size() == 2 && back[0] == 10 && back[1] == 11);
+    };
+    //StackAllocator
+    {
+        CircularBufferArray<int, 5> a;
+        check(a);
+        CircularBufferArray<int, 8> b;
+        check(b);
+    }
+    //HeapAllocator
+    {
+        CircularBufferArray<int, 2000> a;
+        check(a);
+    }
+    //HeapAllocator
+    {
+        CircularBufferArray<int, 5, int> a;
+        check(a);
+    }
+    //Not trivially copyable
+    {
+        CircularBufferArray<std::string, 3> a = {"a", "b", "c"};
+        a.PushBack("d");
+        std::string out[3];
+        ASSERT(a.PopFrontInto(out, 3) == 3);
+        ASSERT(out[0] == "b" && out[1] == "c" && out[2] == "d");
+        ASSERT(a.IsEmpty());
+    }
+}
+void CircBufferBulkTimeTest() {
+    constexpr size_t total = size_t(1) << 22;
+
+    auto run = [](const char* name, size_t block, bool bulk) {
+        CircularBufferArray<int, 65536, int> a;
+        std::vector<int> input(block, 1);
+        std::vector<int> output(block);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t pushed = 0; pushed < total; pushed += block) {
+            if (bulk) {
+                a.PushBackRange(input.data(), block);
+                a.PopFrontInto(output.data(), block);
+            } else {
+                for (size_t i = 0; i < block; ++i) {
+                    a.EmplaceBack(input[i]);
+                }
+                for (size_t i = 0; i < block; ++i) {
+                    output[i] = a.GetFront();
+                    a.PopFront();
+                }
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> duration = end - start;
+        std::cout << "Time taken by " << name << "_" << block << ": " << duration.count() << " seconds" << std::endl;
+    };
+
+    for (size_t block : {size_t(16), size_t(256), size_t(4096), size_t(65536)}) {
+        run("Bulk_Block", block, true);
+        run("PerElement_Block", block, false);
+    }
+}
+void CircBufferMethodArrayOneArrayTwo() {
+    //StackAllocator
+    {
+        CircularBufferArray<int, 5> a;
+        ASSERT(a.ArrayOne().second == 0);
+        ASSERT(a.ArrayTwo().second == 0);
+        a.PushBack(1);
+        a.PushBack(2);
+        a.PushBack(3);
+        ASSERT(a.ArrayOne().second == 3);
+        ASSERT(a.ArrayOne().first[0] == 1);
+        ASSERT(a.ArrayTwo().second == 0);
+        a.PushBack(4);
+        a.PushBack(5);
+        a.PushBack(6);
+        a.PushBack(7);
+        auto one = a.ArrayOne();
+        auto two = a.ArrayTwo();
+        ASSERT(one.second == 3);
+        ASSERT(one.first[0] == 3 && one.first[1] == 4 && one.first[2] == 5);
+        ASSERT(two.second == 2);
+        ASSERT(two.first[0] == 6 && two.first[1] == 7);
+        ASSERT(!a.IsLinearized());
+    }
+    //HeapAllocator
+    {
+        const CircularBufferArray<int, 4, int> a = {1, 2, 3, 4};
+        auto one = a.ArrayOne();
+        ASSERT(one.second == 4);
+        ASSERT(one.first[3] == 4);
+        ASSERT(a.ArrayTwo().second == 0);
+        ASSERT(a.IsLinearized());
+    }
+}
+void CircBufferMethodLinearize() {
+    auto check = [](auto& a, int pushes, int pops) {
+        using value_type = typename std::remove_reference_t<decltype(a)>::value_type;
+        std::vector<value_type> expected;
+        for (int i = 0; i < pushes; ++i) {
+            a.PushBack(value_type(std::to_string(i)));
+            expected.push_back(value_type(std::to_string(i)));
+            if (expected.size() > a.Capacity()) {
+                expected.erase(expected.begin());
+            }
+        }
+        for (int i = 0; i < pops; ++i) {
+            a.PopFront();
+            expected.erase(expected.begin());
+        }
+        auto range = a.Linearize();
+        ASSERT(a.IsLinearized());
+        ASSERT(range.second == expected.size());
+        ASSERT(a.ArrayTwo().second == 0);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT(range.first[i] == expected[i]);
+            ASSERT(a[i] == expected[i]);
+        }
+        // The container keeps working after the rotation
+        a.PushBack(value_type("x"));
+        ASSERT(a.GetBack() == value_type("x"));
+        if (!expected.empty() && expected.size() < a.Capacity()) {
+            ASSERT(a.GetFront() == expected.front());
+        }
+    };
+    for (int pops = 0; pops < 7; ++pops) {
+        //StackAllocator, full and partially full wrapped contents
+        {
+            CircularBufferArray<std::string, 7> a;
+            check(a, 10, pops);
+            CircularBufferArray<std::string, 8> b;
+            check(b, 13, pops);
+        }
+        //HeapAllocator
+        {
+            CircularBufferArray<std::string, 7, int> a;
+            check(a, 10, pops);
+        }
+    }
+    //Already contiguous
+    {
+        CircularBufferArray<std::string, 7> a;
+        check(a, 3, 1);
+    }
+}
+void CircBufferIteratorRandomAccess() {
+    auto check = [](auto& a) {
+        const int capacity = static_cast<int>(a.Capacity());
+        for (int i = 0; i < capacity + 3; ++i) {
+            a.PushBack(i);
+        }
+        auto it = a.begin();
+        ASSERT(a.end() - a.begin() == capacity);
+        ASSERT(*(it + 2) == 5);
+        ASSERT(*(2 + it) == 5);
+        ASSERT(it[capacity - 1] == capacity + 2);
+        it += capacity - 1;
+        ASSERT(*it == capacity + 2);
+        it -= 2;
+        ASSERT(*it == capacity);
+        ASSERT(*(it - 1) == capacity - 1);
+        --it;
+        ASSERT(*it-- == capacity - 1);
+        ASSERT(a.begin() <= it && it < a.end() && a.end() > it && it >= a.begin());
+        ASSERT(a.begin() < a.end() && !(a.end() <= it));
+        ASSERT(a.cend() - a.cbegin() == capacity);
+        typename std::remove_reference_t<decltype(a)>::const_iterator const_it = a.begin();
+        ASSERT(const_it == a.cbegin());
+        int expected = capacity + 2;
+        for (auto r = a.rbegin(); r != a.rend(); ++r, --expected) {
+            ASSERT(*r == expected);
+        }
+        ASSERT(expected == 2);
+        ASSERT(std::distance(a.crbegin(), a.crend()) == capacity);
+    };
+    //StackAllocator
+    {
+        CircularBufferArray<int, 5> a;
+        check(a);
+        CircularBufferArray<int, 8> b;
+        check(b);
+    }
+    //HeapAllocator
+    {
+        CircularBufferArray<int, 2000> a;
+        check(a);
+    }
+    //HeapAllocator
+    {
+        CircularBufferArray<int, 5, int> a;
+        check(a);
+    }
+}
+void CircBufferIteratorAlgorithms() {
+    std::mt19937 random(42);
+    //Wrapped contents, capacity is not a power of two
+    CircularBufferArray<int, 1000, int> a;
+    for (int i = 0; i < 1357; ++i) {
+        a.PushBack(static_cast<int>(random() % 10000));
+    }
+    std::vector<int> vec(a.begin(), a.end());
+
+    std::sort(a.begin(), a.end());
+    std::sort(vec.begin(), vec.end());
+    ASSERT(std::equal(a.begin(), a.end(), vec.begin()));
+    ASSERT(std::is_sorted(a.cbegin(), a.cend()));
+
+    for (int value : {-1, 0, 17, 5000, 9999, 10000}) {
+        auto it = std::lower_bound(a.cbegin(), a.cend(), value);
+        auto vec_it = std::lower_bound(vec.begin(), vec.end(), value);
+        ASSERT(it - a.cbegin() == vec_it - vec.begin());
+    }
+
+    std::shuffle(a.begin(), a.end(), random);
+    std::nth_element(a.begin(), a.begin() + 500, a.end());
+    ASSERT(a[500] == vec[500]);
+
+    std::reverse(a.begin(), a.end());
+    std::sort(a.rbegin(), a.rend());
+    ASSERT(std::equal(a.rbegin(), a.rend(), vec.begin()));
+}
+void CircBufferAlgorithmTimeTest() {
+    constexpr size_t capacity = size_t(1) << 16;
+    std::mt19937 random(42);
+    std::vector<int> values(capacity + capacity / 3);
+    for (int& value : values) {
+        value = static_cast<int>(random());
+    }
+
+    auto LowerBound_Ring_65536 = [&values]()
+    {
+        CircularBufferArray<int, capacity, int> a(values.begin(), values.end());
+        a.PushBackRange(values.data(), values.size());
+        std::sort(a.begin(), a.end());
+        long long found = 0;
+        for (size_t i = 0; i < 100000; ++i) {
+            found += *std::lower_bound(a.cbegin(), a.cend() - 1, values[i % values.size()]);
+        }
+        return found;
+    };
+    auto LowerBound_Vector_65536 = [&values]()
+    {
+        std::vector<int> a(values.end() - capacity, values.end());
+        std::sort(a.begin(), a.end());
+        long long found = 0;
+        for (size_t i = 0; i < 100000; ++i) {
+            found += *std::lower_bound(a.cbegin(), a.cend() - 1, values[i % values.size()]);
+        }
+        return found;
+    };
+    auto NthElement_Ring_65536 = [&values]()
+    {
+        CircularBufferArray<int, capacity, int> a;
+        for (int i = 0; i < 20; ++i) {
+            a.PushBackRange(values.data(), values.size());
+            std::nth_element(a.begin(), a.begin() + capacity / 2, a.end());
+        }
+        return a[capacity / 2];
+    };
+    auto NthElement_Vector_65536 = [&values]()
+    {
+        std::vector<int> a;
+        for (int i = 0; i < 20; ++i) {
+            a.assign(values.end() - capacity, values.end());
+            std::nth_element(a.begin(), a.begin() + capacity / 2, a.end());
+        }
+        return a[capacity / 2];
+    };
+
+    TIME_DIF(LowerBound_Ring_65536)
+    TIME_DIF(LowerBound_Vector_65536)
+    TIME_DIF(NthElement_Ring_65536)
+    TIME_DIF(NthElement_Vector_65536)
+}
+void CircBufferMethodForEach() {
+    auto check = [](auto& a) {
+        const int capacity = static_cast<int>(a.Capacity());
+        int calls = 0;
+        a.ForEach([&calls](int) { ++calls; });
+        a.ForEachSegment([&calls](const int*, size_t) { ++calls; });
+        ASSERT(calls == 0);
+
+        for (int i = 0; i < capacity - 1; ++i) {
+            a.PushBack(i);
+        }
+        int segments = 0;
+        a.ForEachSegment([&segments](const int*, size_t) { ++segments; });
+        ASSERT(segments == 1);
+
+        for (int i = capacity - 1; i < capacity + 2; ++i) {
+            a.PushBack(i);
+        }
+        int expected = 2;
+        a.ForEach([&expected](int value) {
+            ASSERT(value == expected);
+            ++expected;
+        });
+        ASSERT(expected == capacity + 2);
+
+        segments = 0;
+        size_t total = 0;
+        a.ForEachSegment([&segments, &total](const int*, size_t size) {
+            ++segments;
+            total += size;
+        });
+        ASSERT(segments == 2);
+        ASSERT(total == static_cast<size_t>(capacity));
+
+        a.ForEach([](int& value) { value *= 2; });
+        ASSERT(a.GetFront() == 4);
+        const auto& const_a = a;
+        long long sum = 0;
+        const_a.ForEach([&sum](const int& value) { sum += value; });
+        ASSERT(sum == static_cast<long long>(std::accumulate(a.begin(), a.end(), 0LL)));
+    };
+    //StackAllocator
+    {
+        CircularBufferArray<int, 5> a;
+        check(a);
+        CircularBufferArray<int, 8> b;
+        check(b);
+    }
+    //HeapAllocator
+    {
+        CircularBufferArray<int, 2000> a;
+        check(a);
+    }
+    //HeapAllocator
+    {
+        CircularBufferArray<int, 5, int> a;
+        check(a);
+    }
+}
+void CircBufferForEachTimeTest() {
+    constexpr size_t capacity = size_t(1) << 20;
+    using Buffer = CircularBufferArray<int, capacity, int>;
+    auto buffer = std::make_unique<Buffer>();
+    for (size_t i = 0; i < capacity + capacity / 3; ++i) {
+        buffer->PushBack(static_cast<int>(i % 1000));
+    }
+    Buffer& a = *buffer;
+
+    auto Sum_Iterator_1M = [&a]()
+    {
+        long long sum = 0;
+        for (int i = 0; i < 10; ++i) {
+            for (int value : a) {
+                sum += value;
+            }
+        }
+        return sum;
+    };
+    auto Sum_ForEach_1M = [&a]()
+    {
+        long long sum = 0;
+        for (int i = 0; i < 10; ++i) {
+            a.ForEach([&sum](int value) { sum += value; });
+        }
+        return sum;
+    };
+    auto MinMax_Iterator_1M = [&a]()
+    {
+        int min = INT32_MAX;
+        int max = INT32_MIN;
+        for (int i = 0; i < 10; ++i) {
+            for (int value : a) {
+                min = std::min(min, value);
+                max = std::max(max, value);
+            }
+        }
+        return max - min;
+    };
+    auto MinMax_ForEach_1M = [&a]()
+    {
+        int min = INT32_MAX;
+        int max = INT32_MIN;
+        for (int i = 0; i < 10; ++i) {
+            a.ForEach([&min, &max](int value) {
+                min = std::min(min, value);
+                max = std::max(max, value);
+            });
+        }
+        return max - min;
+    };
+
+    TIME_DIF(Sum_Iterator_1M)
+    TIME_DIF(Sum_ForEach_1M)
+    TIME_DIF(MinMax_Iterator_1M)
+    TIME_DIF(MinMax_ForEach_1M)
+}
+void BlockingBufferPushPop() {
+    using namespace std::chrono_literals;
+    //StackAllocator
+    {
+        BlockingCircularBufferArray<int, 3> a;
+        int value = -1;
+        ASSERT(!a.Pop(value, 1ms));
+        ASSERT(!a.TryPop(value));
+        ASSERT(value == -1);
+        ASSERT(a.Push(1, 1ms));
+        ASSERT(a.TryPush(2));
+        ASSERT(a.Push(3));
+        ASSERT(a.IsFull());
+        ASSERT(!a.Push(4, 1ms));
+        ASSERT(!a.TryPush(4));
+        ASSERT(a.Pop(value, 1ms) && value == 1);
+        ASSERT(a.TryPop(value) && value == 2);
+        ASSERT(a.Pop(value) && value == 3);
+        ASSERT(a.IsEmpty());
+    }
+    //HeapAllocator, batch pop
+    {
+        BlockingCircularBufferArray<std::string, 8, int> a(4);
+        for (int i = 0; i < 6; ++i) {
+            ASSERT(a.Push(std::to_string(i)));
+        }
+        std::vector<std::string> out;
+        ASSERT(a.PopBatch(std::back_inserter(out), 4, 1ms) == 4);
+        ASSERT(a.PopBatch(std::back_inserter(out), 4, 1ms) == 2);
+        ASSERT(a.PopBatch(std::back_inserter(out), 4, 1ms) == 0);
+        for (int i = 0; i < 6; ++i) {
+            ASSERT(out[i] == std::to_string(i));
+        }
+    }
+    //Close
+    {
+        BlockingCircularBufferArray<int, 4> a;
+        ASSERT(a.Push(1));
+        a.Close();
+        ASSERT(a.IsClosed());
+        ASSERT(!a.Push(2));
+        int value;
+        ASSERT(a.Pop(value) && value == 1);
+        ASSERT(!a.Pop(value));
+    }
+}
+void BlockingBufferTwoThreads() {
+    using namespace std::chrono_literals;
+    auto check = [](auto& a) {
+        const int count = 50000;
+        std::thread producer([&a]() {
+            for (int i = 0; i < count; ++i) {
+                a.Push(i);
+            }
+            a.Close();
+        });
+        int expected = 0;
+        int value;
+        while (a.Pop(value)) {
+            ASSERT(value == expected);
+            ++expected;
+        }
+        producer.join();
+        ASSERT(expected == count);
+    };
+    //StackAllocator, producer blocks on the small capacity
+    {
+        BlockingCircularBufferArray<int, 4> a;
+        check(a);
+    }
+    //HeapAllocator, batched wakeups
+    {
+        BlockingCircularBufferArray<int, 64, int> a(16, 50us);
+        check(a);
+    }
+    //Consumer blocked on an empty container is woken by Close
+    {
+        BlockingCircularBufferArray<int, 4> a;
+        bool popped = true;
+        std::thread consumer([&a, &popped]() {
+            int value;
+            popped = a.Pop(value);
+        });
+        std::this_thread::sleep_for(1ms);
+        a.Close();
+        consumer.join();
+        ASSERT(!popped);
+    }
+}
+void BlockingBufferTimeTest() {
+    // Producer sends its clock reading, consumer records the latency of every element.
+    // "interval" paces the producer below the consumer's rate, so the latency is the handoff through the wake
+    // path, a zero interval pushes as fast as possible and the latency is mostly waiting in a full queue.
+    auto run = [](const std::string& name, size_t wakeup_batch, std::chrono::microseconds interval, int count) {
+        BlockingCircularBufferArray<long long, 1024, int> a(wakeup_batch, std::chrono::microseconds(50));
+        std::vector<long long> latencies;
+        latencies.reserve(count);
+        auto now = []() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        };
+        auto start = std::chrono::steady_clock::now();
+        std::thread producer([&a, &now, interval, count]() {
+            auto next = std::chrono::steady_clock::now();
+            for (int i = 0; i < count; ++i) {
+                if (interval.count() != 0) {
+                    next += interval;
+                    std::this_thread::sleep_until(next);
+                }
+                a.Push(now());
+            }
+            a.Close();
+        });
+        long long sent;
+        while (a.Pop(sent)) {
+            latencies.push_back(now() - sent);
+        }
+        producer.join();
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) {
+            return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+        };
+        std::cout << "Time taken by " << name << ": " << duration.count() << " seconds" << std::endl;
+        std::cout << "Latency of " << name << ": p50=" << percentile(0.5) << " p99=" << percentile(0.99)
+                  << " p999=" << percentile(0.999) << " ns" << std::endl;
+    };
+
+    for (size_t wakeup_batch : {size_t(1), size_t(16), size_t(256)}) {
+        const std::string batch = std::to_string(wakeup_batch);
+        run("Blocking_Handoff_Batch_" + batch, wakeup_batch, std::chrono::microseconds(100), 5000);
+        run("Blocking_Saturated_Batch_" + batch, wakeup_batch, std::chrono::microseconds(0), 200000);
+    }
+}
+void CircBufferOverflowPolicy() {
+    auto check = [](auto& a) {
+        for (int i = 0; i < 4; ++i) {
+            ASSERT(a.EmplaceBack(i) != nullptr);
+        }
+        ASSERT(a.IsFull());
+        ASSERT(a.EmplaceBack(4) == nullptr);
+        ASSERT(a.PushBack(5) == nullptr);
+        ASSERT(a.Size() == 4);
+        ASSERT(a.GetFront() == 0 && a.GetBack() == 3);
+
+        a.PopFront();
+        a.PopFront();
+        const int data[] = {10, 11, 12};
+        ASSERT(a.PushBackRange(data, 3) == 2);
+        ASSERT(a[0] == 2 && a[1] == 3 && a[2] == 10 && a[3] == 11);
+
+        a.PopFront();
+        std::vector<int> more = {20, 21};
+        ASSERT(a.PushBackRange(more.begin(), more.end()) == 1);
+        ASSERT(a.GetBack() == 20);
+    };
+
+    //StackAllocator
+    {
+        CircularBufferArray<int, 4, bool, RejectPolicy> a;
+        check(a);
+    }
+
+    //HeapAllocator
+    {
+        CircularBufferArray<int, 4, int, RejectPolicy> a;
+        check(a);
+    }
+
+    //StandardAllocator
+    {
+        CircularBufferArray<int, 4, std::allocator<int>, RejectPolicy> a;
+        check(a);
+    }
+
+    //OverwritePolicy stays the default
+    {
+        CircularBufferArray<int, 4> a;
+        const int data[] = {1, 2, 3, 4, 5, 6};
+        ASSERT(a.PushBackRange(data, 6) == 6);
+        ASSERT(a.GetFront() == 3 && a.GetBack() == 6);
+    }
+}
+
+void RuntimeCircBufferOverflowPolicy() {
+    //RejectPolicy
+    {
+        CircularBuffer<std::string, std::allocator<std::string>, RejectPolicy> a(2);
+        ASSERT(a.PushBack("a") != nullptr);
+        ASSERT(a.PushBack("b") != nullptr);
+        ASSERT(a.PushBack("c") == nullptr);
+        ASSERT(a.Size() == 2 && a.GetFront() == "a" && a.GetBack() == "b");
+
+        CircularBuffer<int, std::allocator<int>, RejectPolicy> empty;
+        ASSERT(empty.EmplaceBack(1) == nullptr);
+    }
+
+    //GrowPolicy
+    {
+        CircularBuffer<std::string, std::allocator<std::string>, GrowPolicy> a;
+        for (int i = 0; i < 100; ++i) {
+            ASSERT(a.PushBack(std::to_string(i)) != nullptr);
+        }
+        ASSERT(a.Size() == 100 && a.Capacity() >= 100);
+        for (int i = 0; i < 100; ++i) {
+            ASSERT(a[i] == std::to_string(i));
+        }
+
+        // Wrapped buffer keeps its order when it grows
+        CircularBuffer<int, std::allocator<int>, GrowPolicy> b(4);
+        for (int i = 0; i < 4; ++i) b.PushBack(i);
+        b.PopFront();
+        b.PopFront();
+        b.PushBack(4);
+        b.PushBack(5);
+        b.PushBack(6);
+        ASSERT(b.Capacity() == 8 && b.Size() == 5);
+        for (int i = 0; i < 5; ++i) {
+            ASSERT(b[i] == i + 2);
+        }
+
+        // Element of the container itself may be pushed while it grows
+        CircularBuffer<std::string, std::allocator<std::string>, GrowPolicy> c(1);
+        c.PushBack(std::string(64, 'x'));
+        c.PushBack(c.GetFront());
+        ASSERT(c.Size() == 2 && c.GetBack() == std::string(64, 'x'));
+    }
+}
+
+void CircBufferOverflowPolicyTimeTest() {
+    constexpr size_t total = size_t(1) << 24;
+    constexpr size_t capacity = 4096;
+
+    auto run = [](const char* name, auto&& push, auto&& drain) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < total; ++i) {
+            push(static_cast<int>(i));
+            if ((i & (capacity - 1)) == capacity - 1) {
+                drain();
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> duration = end - start;
+        std::cout << "Time taken by " << name << ": " << duration.count() << " seconds" << std::endl;
+    };
+
+    std::vector<int> output(capacity);
+    {
+        CircularBufferArray<int, capacity, int> a;
+        run("Overwrite", [&a](int v) { a.EmplaceBack(v); },
+            [&]() { a.PopFrontInto(output.data(), capacity / 2); });
+    }
+    {
+        CircularBufferArray<int, capacity, int> a;
+        run("Overwrite_CheckIsFull", [&a](int v) { if (!a.IsFull()) a.EmplaceBack(v); },
+            [&]() { a.PopFrontInto(output.data(), capacity / 2); });
+    }
+    {
+        CircularBufferArray<int, capacity, int, RejectPolicy> a;
+        run("Reject", [&a](int v) { a.EmplaceBack(v); },
+            [&]() { a.PopFrontInto(output.data(), capacity / 2); });
+    }
+    {
+        CircularBuffer<int, std::allocator<int>, GrowPolicy> a(1);
+        run("Grow", [&a](int v) { a.EmplaceBack(v); },
+            [&]() { for (size_t i = 0; i < capacity / 2; ++i) a.PopFront(); });
+    }
+    {
+        BlockingCircularBufferArray<int, capacity, int> a;
+        int value;
+        run("Block_TryPush", [&a](int v) { a.TryPush(v); },
+            [&]() { for (size_t i = 0; i < capacity / 2; ++i) a.TryPop(value); });
+    }
+}
+
+namespace {
+// Path of a file in the temporary directory, unique for the process.
+std::string TempFilePath(const char* name) {
+    return (std::filesystem::temp_directory_path()
+            / (std::string(name) + "_" + std::to_string(getpid()))).string();
+}
+}
+
+void MappedCircBufferRecover() {
+    const std::string path = TempFilePath("mapped_circular_buffer");
+    std::filesystem::remove(path);
+
+    // Child process writes and dies without closing the file
+    pid_t pid = fork();
+    ASSERT(pid != -1);
+    if (pid == 0) {
+        MappedCircularBufferArray<long long, 100> a(path);
+        for (long long i = 0; i < 150; ++i) {
+            a.PushBack(i);
+        }
+        std::vector<long long> range(30);
+        std::iota(range.begin(), range.end(), 150);
+        a.PushBackRange(range.data(), range.size());
+        a.PopFront();
+        _exit(0);
+    }
+    int status = 0;
+    ASSERT(waitpid(pid, &status, 0) == pid);
+    ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    {
+        MappedCircularBufferArray<long long, 100> a(path);
+        ASSERT(a.IsRecovered());
+        ASSERT(a.Size() == 99);
+        ASSERT(a.GetFront() == 81 && a.GetBack() == 179);
+        for (size_t i = 0; i < a.Size(); ++i) {
+            ASSERT(a[i] == static_cast<long long>(81 + i));
+        }
+        a.PushBack(180);
+        a.Sync();
+    }
+
+    {
+        MappedCircularBufferArray<long long, 100> a(path);
+        ASSERT(a.IsRecovered() && a.IsFull());
+        ASSERT(a.GetFront() == 81 && a.GetBack() == 180);
+        a.Clear();
+    }
+
+    {
+        MappedCircularBufferArray<long long, 100> a(path);
+        ASSERT(a.IsEmpty());
+    }
+
+    // File written with another capacity is refused
+    bool refused = false;
+    try {
+        MappedCircularBufferArray<long long, 200> a(path);
+    } catch (const std::runtime_error&) {
+        refused = true;
+    }
+    ASSERT(refused);
+
+    std::filesystem::remove(path);
+}
+
+void MappedCircBufferTimeTest() {
+    struct Event {
+        long long time;
+        long long id;
+        double values[2];
+    };
+    constexpr size_t capacity = 65536;
+    constexpr size_t total = size_t(1) << 23;
+    const Event event{1, 2, {3.0, 4.0}};
+
+    auto run = [](const char* name, auto& a, Event event) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < total; ++i) {
+            a.PushBack(event);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> duration = end - start;
+        std::cout << "Time taken by " << name << ": " << duration.count() << " seconds" << std::endl;
+    };
+
+    {
+        CircularBufferArray<Event, capacity, int> a;
+        run("Heap_PushBack", a, event);
+    }
+
+    const std::string path = TempFilePath("mapped_circular_buffer_time");
+    auto run_mapped = [&](const char* name, MappedCircularBufferOptions options) {
+        std::filesystem::remove(path);
+        MappedCircularBufferArray<Event, capacity> a(path, options);
+        run(name, a, event);
+    };
+    run_mapped("Mapped_PushBack", {});
+    run_mapped("Mapped_PushBack_HugePages", {true, 0});
+    run_mapped("Mapped_PushBack_Sync_65536", {false, capacity});
+
+    {
+        std::filesystem::remove(path);
+        MappedCircularBufferArray<Event, capacity> a(path);
+        std::vector<Event> block(256, event);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t pushed = 0; pushed < total; pushed += block.size()) {
+            a.PushBackRange(block.data(), block.size());
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> duration = end - start;
+        std::cout << "Time taken by Mapped_PushBackRange_256: " << duration.count() << " seconds" << std::endl;
+    }
+    std::filesystem::remove(path);
+}
+
+void SharedSpscBufferTwoProcesses() {
+    using Buffer = SharedSpscCircularBufferArray<long long, 100>;
+    const std::string name = "/shared_spsc_test_" + std::to_string(getpid());
+    constexpr long long count = 100000;
+    Buffer::Unlink(name);
+
+    pid_t pid = fork();
+    ASSERT(pid != -1);
+    if (pid == 0) {
+        int result = 0;
+        try {
+            Buffer consumer = Buffer::AttachConsumer(name);
+            long long value;
+            for (long long expected = 0; expected < count; ++expected) {
+                while (!consumer.TryPop(value)) {
+                    std::this_thread::yield();
+                }
+                if (value != expected) {
+                    result = 1;
+                    break;
+                }
+            }
+        } catch (...) {
+            result = 2;
+        }
+        _exit(result);
+    }
+
+    {
+        Buffer producer = Buffer::AttachProducer(name);
+        ASSERT(producer.IsProducer() && producer.Capacity() == 100);
+
+        bool refused = false;
+        try {
+            Buffer other = Buffer::AttachProducer(name);
+        } catch (const std::runtime_error&) {
+            refused = true;
+        }
+        ASSERT(refused);
+
+        for (long long i = 0; i < count; ++i) {
+            while (!producer.TryPush(i)) {
+                std::this_thread::yield();
+            }
+        }
+        int status = 0;
+        ASSERT(waitpid(pid, &status, 0) == pid);
+        ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        ASSERT(producer.IsEmpty());
+    }
+
+    // Segment with another layout is refused
+    bool refused = false;
+    try {
+        auto other = SharedSpscCircularBufferArray<long long, 200>::AttachProducer(name);
+    } catch (const std::runtime_error&) {
+        refused = true;
+    }
+    ASSERT(refused);
+    ASSERT(Buffer::Unlink(name));
+}
+
+void SharedSpscBufferTimeTest() {
+    // Round trip of a message to a child process and back, the child echoes every message.
+    constexpr int count = 20000;
+    auto now = []() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    };
+    auto report = [](const char* name, std::vector<long long>& latencies, double seconds) {
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) {
+            return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+        };
+        std::cout << "Time taken by " << name << ": " << seconds << " seconds" << std::endl;
+        std::cout << "Latency of " << name << ": p50=" << percentile(0.5) << " p99=" << percentile(0.99)
+                  << " p999=" << percentile(0.999) << " ns" << std::endl;
+    };
+
+    {
+        using Buffer = SharedSpscCircularBufferArray<long long, 1024>;
+        const std::string ping_name = "/shared_spsc_ping_" + std::to_string(getpid());
+        const std::string pong_name = "/shared_spsc_pong_" + std::to_string(getpid());
+        Buffer::Unlink(ping_name);
+        Buffer::Unlink(pong_name);
+
+        pid_t pid = fork();
+        ASSERT(pid != -1);
+        if (pid == 0) {
+            try {
+                Buffer ping = Buffer::AttachConsumer(ping_name);
+                Buffer pong = Buffer::AttachProducer(pong_name);
+                long long value;
+                for (int i = 0; i < count; ++i) {
+                    while (!ping.TryPop(value)) std::this_thread::yield();
+                    while (!pong.TryPush(value)) std::this_thread::yield();
+                }
+            } catch (...) {
+                _exit(1);
+            }
+            _exit(0);
+        }
+
+        Buffer ping = Buffer::AttachProducer(ping_name);
+        Buffer pong = Buffer::AttachConsumer(pong_name);
+        std::vector<long long> latencies;
+        latencies.reserve(count);
+        auto start = std::chrono::steady_clock::now();
+        long long value;
+        for (int i = 0; i < count; ++i) {
+            const long long sent = now();
+            while (!ping.TryPush(sent)) std::this_thread::yield();
+            while (!pong.TryPop(value)) std::this_thread::yield();
+            latencies.push_back(now() - value);
+        }
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        int status = 0;
+        ASSERT(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        Buffer::Unlink(ping_name);
+        Buffer::Unlink(pong_name);
+        report("Shm_RoundTrip", latencies, duration.count());
+    }
+
+    {
+        int ping[2];
+        int pong[2];
+        ASSERT(pipe(ping) == 0 && pipe(pong) == 0);
+        pid_t pid = fork();
+        ASSERT(pid != -1);
+        if (pid == 0) {
+            close(ping[1]);
+            close(pong[0]);
+            long long value;
+            for (int i = 0; i < count; ++i) {
+                if (read(ping[0], &value, sizeof(value)) != sizeof(value)) _exit(1);
+                if (write(pong[1], &value, sizeof(value)) != sizeof(value)) _exit(1);
+            }
+            _exit(0);
+        }
+        close(ping[0]);
+        close(pong[1]);
+        std::vector<long long> latencies;
+        latencies.reserve(count);
+        auto start = std::chrono::steady_clock::now();
+        long long value;
+        for (int i = 0; i < count; ++i) {
+            const long long sent = now();
+            ASSERT(write(ping[1], &sent, sizeof(sent)) == sizeof(sent));
+            ASSERT(read(pong[0], &value, sizeof(value)) == sizeof(value));
+            latencies.push_back(now() - value);
+        }
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        close(ping[1]);
+        close(pong[0]);
+        int status = 0;
+        ASSERT(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        report("Pipe_RoundTrip", latencies, duration.count());
+    }
+}
+
+namespace {
+// Eight floats of one AVX register.
+struct alignas(32) Avx8f {
+    float v[8];
+};
+
+struct alignas(64) CacheLineValue {
+    long long value;
+};
+
+template<typename T>
+bool IsAligned(const T* ptr, size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Aligned loads fault on a misaligned element, so the sum checks the storage alignment as well.
+__attribute__((target("avx"))) float SumAvx(const Avx8f* data, size_t count) {
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t i = 0; i < count; ++i) {
+        sum = _mm256_add_ps(sum, _mm256_load_ps(data[i].v));
+    }
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, sum);
+    return std::accumulate(lanes, lanes + 8, 0.0f);
+}
+#endif
+
+float SumScalar(const Avx8f* data, size_t count) {
+    float sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        for (float value : data[i].v) {
+            sum += value;
+        }
+    }
+    return sum;
+}
+
+float SumAvx8f(const Avx8f* data, size_t count) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx")) {
+        return SumAvx(data, count);
+    }
+#endif
+    return SumScalar(data, count);
+}
+}
+
+void CircBufferAlignment() {
+    auto check = [](auto& a, size_t alignment) {
+        using value_type = typename std::remove_reference_t<decltype(a)>::value_type;
+        for (size_t i = 0; i < a.Capacity() + 3; ++i) {
+            a.EmplaceBack(value_type{});
+        }
+        ASSERT(IsAligned(a.Linearize().first, alignment));
+        for (size_t i = 0; i < a.Size(); ++i) {
+            ASSERT(IsAligned(&a[i], alignof(value_type)));
+        }
+    };
+
+    //StackAllocator
+    {
+        CircularBufferArray<Avx8f, 16> a;
+        check(a, alignof(Avx8f));
+        CircularBufferArray<CacheLineValue, 16> b;
+        check(b, alignof(CacheLineValue));
+    }
+
+    //HeapAllocator
+    {
+        CircularBufferArray<Avx8f, 1000, int> a;
+        check(a, alignof(Avx8f));
+        CircularBufferArray<CacheLineValue, 1000, int> b;
+        check(b, alignof(CacheLineValue));
+    }
+
+    //AlignedHeap
+    {
+        CircularBufferArray<int, 1000, AlignedHeap<64>> a;
+        check(a, 64);
+        CircularBufferArray<Avx8f, 1000, AlignedHeap<128>> b;
+        check(b, 128);
+    }
+
+    //StandardAllocator
+    {
+        CircularBufferArray<Avx8f, 1000, std::allocator<Avx8f>> a;
+        check(a, alignof(Avx8f));
+    }
+
+    //Over-aligned element survives relocation of the runtime capacity buffer
+    {
+        CircularBuffer<Avx8f> a(3);
+        for (int i = 0; i < 100; ++i) {
+            Avx8f value{};
+            value.v[0] = static_cast<float>(i);
+            a.Reserve(a.Size() + 1);
+            a.PushBack(value);
+        }
+        for (size_t i = 0; i < a.Size(); ++i) {
+            ASSERT(IsAligned(&a[i], alignof(Avx8f)) && a[i].v[0] == static_cast<float>(i));
+        }
+    }
+}
+
+void ConcurrentBufferPaddedSlots() {
+    //Spsc
+    {
+        SpscCircularBufferArray<int, 16, bool, true> a;
+        SpscCircularBufferArray<int, 1000, int, true> b;
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < 16; ++i) {
+                ASSERT(a.TryPush(i));
+                ASSERT(b.TryPush(i));
+            }
+            ASSERT(!a.TryPush(16) && a.IsFull());
+            int value;
+            for (int i = 0; i < 16; ++i) {
+                ASSERT(a.TryPop(value) && value == i);
+                ASSERT(b.TryPop(value) && value == i);
+            }
+            ASSERT(a.IsEmpty() && b.IsEmpty());
+        }
+
+        SpscCircularBufferArray<std::string, 4, int, true> c;
+        ASSERT(c.TryPush(std::string(64, 'x')));
+        std::string value;
+        ASSERT(c.TryPop(value) && value == std::string(64, 'x'));
+        ASSERT(c.TryPush(std::string(64, 'y')));
+    }
+
+    //Mpmc
+    {
+        MpmcCircularBufferArray<int, 16, bool, true> a;
+        MpmcCircularBufferArray<int, 1000, int, true> b;
+        for (int i = 0; i < 16; ++i) {
+            ASSERT(a.TryPush(i));
+            ASSERT(b.TryPush(i));
+        }
+        ASSERT(!a.TryPush(16));
+        int value;
+        for (int i = 0; i < 16; ++i) {
+            ASSERT(a.TryPop(value) && value == i);
+            ASSERT(b.TryPop(value) && value == i);
+        }
+        ASSERT(a.IsEmpty() && b.IsEmpty());
+    }
+}
+
+void CircBufferAlignmentTimeTest() {
+    constexpr size_t capacity = 4096;
+    constexpr size_t rounds = 2000;
+
+    auto run_sum = [](const char* name, auto& a) {
+        for (size_t i = 0; i < capacity; ++i) {
+            Avx8f value{};
+            std::fill(value.v, value.v + 8, 1.0f);
+            a.PushBack(value);
+        }
+        float sum = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t r = 0; r < rounds; ++r) {
+            a.ForEachSegment([&sum](const Avx8f* data, size_t count) {
+                sum += SumAvx8f(data, count);
+            });
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        ASSERT(sum > 0);
+        std::chrono::duration<double> duration = end - start;
+        std::cout << "Time taken by " << name << ": " << duration.count() << " seconds" << std::endl;
+    };
+
+    {
+        CircularBufferArray<Avx8f, capacity, int> a;
+        run_sum("Avx8f_Sum_Heap", a);
+    }
+    {
+        CircularBufferArray<Avx8f, capacity, AlignedHeap<64>> a;
+        run_sum("Avx8f_Sum_AlignedHeap_64", a);
+    }
+    {
+        CircularBufferArray<Avx8f, capacity, AlignedHeap<128>> a;
+        run_sum("Avx8f_Sum_AlignedHeap_128", a);
+    }
+
+    // Two threads on a small buffer, padding keeps the slots written by the producer and read by the consumer apart
+    auto run_spsc = [](const char* name, auto& a) {
+        constexpr int count = 1000000;
+        auto start = std::chrono::high_resolution_clock::now();
+        std::thread producer([&a]() {
+            for (int i = 0; i < count; ++i) {
+                while (!a.TryPush(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        int value;
+        for (int i = 0; i < count; ++i) {
+            while (!a.TryPop(value)) {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> duration = end - start;
+        std::cout << "Time taken by " << name << ": " << duration.count() << " seconds" << std::endl;
+    };
+
+    {
+        SpscCircularBufferArray<int, 64, int> a;
+        run_spsc("Spsc_64", a);
+    }
+    {
+        SpscCircularBufferArray<int, 64, int, true> a;
+        run_spsc("Spsc_64_PaddedSlots", a);
+    }
+    {
+        MpmcCircularBufferArray<int, 64, int> a;
+        run_spsc("Mpmc_64", a);
+    }
+    {
+        MpmcCircularBufferArray<int, 64, int, true> a;
+        run_spsc("Mpmc_64_PaddedSlots", a);
+    }
+}
+
+namespace {
+// Copy throws when "throw_on_copy" is set, moves never throw.
+struct ThrowingCopy {
+    static inline bool throw_on_copy = false;
+    std::string value;
+
+    ThrowingCopy(const char* value) : value(value) {}
+    ThrowingCopy(const ThrowingCopy& other) : value(other.value) {
+        if (throw_on_copy) throw std::runtime_error("copy");
+    }
+    ThrowingCopy(ThrowingCopy&& other) noexcept = default;
+    ThrowingCopy& operator=(const ThrowingCopy& other) = default;
+    ThrowingCopy& operator=(ThrowingCopy&& other) noexcept = default;
+};
+}
+
+void CircBufferMoveOnly() {
+    auto check = [](auto& a) {
+        for (int i = 0; i < 6; ++i) {
+            ASSERT(**a.PushBack(std::make_unique<int>(i)) == i);
+        }
+        ASSERT(a.Size() == 4 && *a.GetFront() == 2 && *a.GetBack() == 5);
+        a.EmplaceBack(new int(6));
+        ASSERT(*a.GetFront() == 3);
+
+        std::unique_ptr<int> front = a.ReleaseFront();
+        std::unique_ptr<int> back = a.ReleaseBack();
+        ASSERT(*front == 3 && *back == 6 && a.Size() == 2);
+
+        std::unique_ptr<int> out[2];
+        ASSERT(a.PopFrontInto(out, 2) == 2);
+        ASSERT(*out[0] == 4 && *out[1] == 5 && a.IsEmpty());
+    };
+
+    //StackAllocator
+    {
+        CircularBufferArray<std::unique_ptr<int>, 4> a;
+        check(a);
+    }
+
+    //HeapAllocator
+    {
+        CircularBufferArray<std::unique_ptr<int>, 4, int> a;
+        check(a);
+    }
+
+    //Move construction and assignment leave the source empty
+    {
+        CircularBufferArray<std::unique_ptr<int>, 4, int> a;
+        for (int i = 0; i < 5; ++i) {
+            a.PushBack(std::make_unique<int>(i));
+        }
+        CircularBufferArray<std::unique_ptr<int>, 4, int> b(std::move(a));
+        ASSERT(a.IsEmpty() && b.Size() == 4 && *b.GetFront() == 1 && *b.GetBack() == 4);
+        CircularBufferArray<std::unique_ptr<int>, 4, int> c;
+        c.PushBack(std::make_unique<int>(10));
+        c = std::move(b);
+        ASSERT(b.IsEmpty() && c.Size() == 4 && *c[0] == 1 && *c[3] == 4);
+    }
+
+    //Runtime capacity
+    {
+        CircularBuffer<std::unique_ptr<int>> a(2);
+        a.PushBack(std::make_unique<int>(1));
+        a.PushBack(std::make_unique<int>(2));
+        a.PushBack(std::make_unique<int>(3));
+        ASSERT(*a.GetFront() == 2);
+        a.Reserve(8);
+        ASSERT(*a.ReleaseFront() == 2 && *a.ReleaseBack() == 3 && a.IsEmpty());
+    }
+
+    //Rvalues are moved, lvalues are copied, released elements are not copied
+    {
+        using Counter = RelocationCounter<true>;
+        CircularBufferArray<Counter, 4, int> a;
+        Counter value(1);
+        Counter::Reset();
+        a.PushBack(value);
+        ASSERT(Counter::copies == 1 && Counter::moves == 0);
+        a.PushBack(Counter(2));
+        ASSERT(Counter::copies == 1 && Counter::moves == 1);
+        Counter::Reset();
+        Counter front = a.ReleaseFront();
+        ASSERT(front.value == 1 && Counter::copies == 0);
+    }
+}
+
+void CircBufferExceptionSafety() {
+    auto check = [](auto& a) {
+        ThrowingCopy value("x");
+        for (const char* s : {"a", "b", "c"}) {
+            a.EmplaceBack(s);
+        }
+
+        // Not full
+        ThrowingCopy::throw_on_copy = true;
+        bool thrown = false;
+        try {
+            a.PushBack(value);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        ThrowingCopy::throw_on_copy = false;
+        ASSERT(thrown && a.Size() == 3 && a.GetBack().value == "c");
+
+        // Full, the front element is not erased
+        a.EmplaceBack("d");
+        ThrowingCopy::throw_on_copy = true;
+        thrown = false;
+        try {
+            a.PushBack(value);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        ThrowingCopy::throw_on_copy = false;
+        ASSERT(thrown && a.Size() == 4 && a.GetFront().value == "a" && a.GetBack().value == "d");
+
+        // Pushing own front element while full
+        a.PushBack(a.GetFront());
+        ASSERT(a.GetFront().value == "b" && a.GetBack().value == "a");
+    };
+
+    //StackAllocator
+    {
+        CircularBufferArray<ThrowingCopy, 4> a;
+        check(a);
+    }
+
+    //HeapAllocator
+    {
+        CircularBufferArray<ThrowingCopy, 4, int> a;
+        check(a);
+    }
+
+    //Runtime capacity
+    {
+        CircularBuffer<ThrowingCopy> a(4);
+        check(a);
+    }
+
+    //Copy construction and assignment
+    {
+        CircularBufferArray<ThrowingCopy, 4, int> a;
+        for (const char* s : {"a", "b", "c", "d", "e"}) {
+            a.EmplaceBack(s);
+        }
+        CircularBufferArray<ThrowingCopy, 4, int> b(a);
+        ASSERT(b.Size() == 4 && b.GetFront().value == "b" && b.GetBack().value == "e" && a.Size() == 4);
+        CircularBufferArray<ThrowingCopy, 4, int> c;
+        c.EmplaceBack("z");
+        c = a;
+        ASSERT(c.Size() == 4 && c[0].value == "b" && c[3].value == "e");
+
+        ThrowingCopy::throw_on_copy = true;
+        bool thrown = false;
+        try {
+            CircularBufferArray<ThrowingCopy, 4, int> d(a);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        ThrowingCopy::throw_on_copy = false;
+        ASSERT(thrown);
+    }
+}
+
+void SlidingWindowStatsMethods() {
+    auto check = [](auto& stats, const std::vector<int>& input) {
+        const size_t window = stats.Capacity();
+        for (size_t i = 0; i < input.size(); ++i) {
+            stats.PushBack(input[i]);
+            const size_t first = i + 1 > window ? i + 1 - window : 0;
+            const size_t count = i + 1 - first;
+            long long sum = 0;
+            int min = input[first];
+            int max = input[first];
+            for (size_t j = first; j <= i; ++j) {
+                sum += input[j];
+                min = std::min(min, input[j]);
+                max = std::max(max, input[j]);
+            }
+            const double mean = static_cast<double>(sum) / count;
+            double variance = 0;
+            for (size_t j = first; j <= i; ++j) {
+                variance += (input[j] - mean) * (input[j] - mean);
+            }
+            variance /= count;
+            ASSERT(stats.Size() == count);
+            ASSERT(stats.Sum() == sum);
+            ASSERT(std::abs(stats.Mean() - mean) < 1e-6);
+            ASSERT(std::abs(stats.Variance() - variance) < 1e-6 * std::max(1.0, variance));
+            ASSERT(stats.Min() == min && stats.Max() == max);
+        }
+    };
+
+    std::mt19937 generator(16);
+    std::uniform_int_distribution<int> distribution(-1000, 1000);
+    std::vector<int> input(2000);
+    for (int& value : input) {
+        value = distribution(generator);
+    }
+
+    //StackAllocator
+    {
+        SlidingWindowStats<int, 1> a;
+        check(a, input);
+        SlidingWindowStats<int, 7> b;
+        check(b, input);
+    }
+
+    //HeapAllocator
+    {
+        SlidingWindowStats<int, 64, int> a;
+        check(a, input);
+    }
+
+    // Monotonic input keeps every sample as a min or max candidate
+    {
+        std::vector<int> increasing(300);
+        std::iota(increasing.begin(), increasing.end(), 0);
+        SlidingWindowStats<int, 16> a;
+        check(a, increasing);
+        std::reverse(increasing.begin(), increasing.end());
+        a.Clear();
+        ASSERT(a.IsEmpty());
+        check(a, increasing);
+    }
+
+    //Floating point samples
+    {
+        SlidingWindowStats<double, 3> a;
+        for (double value : {1.0, 2.0, 4.0, 8.0}) {
+            a.PushBack(value);
+        }
+        ASSERT(a.Sum() == 14.0 && a.Min() == 2.0 && a.Max() == 8.0);
+        ASSERT(std::abs(a.SampleVariance() - 9.333333333) < 1e-6);
+    }
+}
+
+void SlidingWindowAggregatorMethods() {
+    // Composition of affine functions x -> a * x + b is associative but not commutative.
+    struct Affine {
+        long long a = 1;
+        long long b = 0;
+        bool operator==(const Affine& other) const {
+            return a == other.a && b == other.b;
+        }
+    };
+    struct Compose {
+        Affine operator()(const Affine& first, const Affine& second) const {
+            return {second.a * first.a % 1000003, (second.a * first.b + second.b) % 1000003};
+        }
+    };
+
+    std::mt19937 generator(16);
+    std::uniform_int_distribution<int> distribution(0, 1000);
+
+    auto check = [&generator, &distribution](auto& aggregator, auto make_value, auto op) {
+        using value_type = typename std::remove_reference_t<decltype(aggregator)>::value_type;
+        std::vector<value_type> input;
+        for (int i = 0; i < 1000; ++i) {
+            input.push_back(make_value(distribution(generator)));
+            aggregator.PushBack(input.back());
+            const size_t first = input.size() > aggregator.Capacity() ? input.size() - aggregator.Capacity() : 0;
+            value_type expected = input[first];
+            for (size_t j = first + 1; j < input.size(); ++j) {
+                expected = op(expected, input[j]);
+            }
+            ASSERT(aggregator.Size() == input.size() - first);
+            ASSERT(aggregator.Get() == expected);
+        }
+    };
+
+    //StackAllocator
+    {
+        SlidingWindowAggregator<long long, 10, std::plus<long long>> a;
+        check(a, [](int v) { return static_cast<long long>(v); }, std::plus<long long>());
+        SlidingWindowAggregator<int, 1, MinOp<int>> b;
+        check(b, [](int v) { return v; }, MinOp<int>());
+        SlidingWindowAggregator<int, 33, MaxOp<int>> c;
+        check(c, [](int v) { return v; }, MaxOp<int>());
+        SlidingWindowAggregator<Affine, 17, Compose> d;
+        check(d, [](int v) { return Affine{v + 1, v}; }, Compose());
+    }
+
+    //HeapAllocator
+    {
+        SlidingWindowAggregator<Affine, 100, Compose, int> a;
+        check(a, [](int v) { return Affine{v + 1, v}; }, Compose());
+    }
+
+    //PopFront shrinks the window
+    {
+        SlidingWindowAggregator<int, 4, std::plus<int>> a;
+        for (int i = 1; i <= 6; ++i) {
+            a.PushBack(i);
+        }
+        ASSERT(a.Get() == 3 + 4 + 5 + 6);
+        a.PopFront();
+        ASSERT(a.Get() == 4 + 5 + 6);
+        a.PopFront();
+        a.PushBack(7);
+        ASSERT(a.Get() == 5 + 6 + 7 && a.Size() == 3);
+        a.Clear();
+        ASSERT(a.IsEmpty());
+        a.PushBack(1);
+        ASSERT(a.Get() == 1);
+    }
+}
+
+namespace {
+template<size_t _Window>
+void SlidingWindowTimeTestRun(const std::vector<double>& input) {
+    // Naive recomputation is O(window) per push, it gets fewer pushes so large windows finish in time.
+    const size_t naive_pushes = std::max<size_t>(16, (size_t(1) << 23) / _Window);
+    auto report = [](const char* name, double seconds, size_t pushes) {
+        std::cout << "Time per push of " << name << "_" << _Window << ": "
+                  << seconds * 1e9 / static_cast<double>(pushes) << " ns" << std::endl;
+    };
+
+    double checksum = 0;
+    {
+        auto stats = std::make_unique<SlidingWindowStats<double, _Window, int>>();
+        auto start = std::chrono::high_resolution_clock::now();
+        for (double value : input) {
+            stats->PushBack(value);
+            checksum += stats->Mean() + stats->Variance() + stats->Min() + stats->Max();
+        }
+        std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+        report("Stats_Incremental", duration.count(), input.size());
+    }
+    {
+        auto aggregator = std::make_unique<SlidingWindowAggregator<double, _Window, MaxOp<double>, int>>();
+        auto start = std::chrono::high_resolution_clock::now();
+        for (double value : input) {
+            aggregator->PushBack(value);
+            checksum += aggregator->Get();
+        }
+        std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+        report("Aggregator_Max", duration.count(), input.size());
+    }
+    {
+        CircularBufferArray<double, _Window, int> window;
+        for (size_t i = 0; i < _Window; ++i) {
+            window.PushBack(input[i % input.size()]);
+        }
+        const size_t pushes = std::min(naive_pushes, input.size());
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < pushes; ++i) {
+            window.PushBack(input[i]);
+            double sum = 0;
+            double sum_squares = 0;
+            double min = window.GetFront();
+            double max = min;
+            window.ForEach([&](double value) {
+                sum += value;
+                sum_squares += value * value;
+                min = std::min(min, value);
+                max = std::max(max, value);
+            });
+            const double mean = sum / window.Size();
+            checksum += mean + (sum_squares / window.Size() - mean * mean) + min + max;
+        }
+        std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+        report("Stats_Naive", duration.count(), pushes);
+    }
+    if (checksum == 0) std::cout << checksum << std::endl;
+}
+}
+
+void SlidingWindowTimeTest() {
+    std::mt19937 generator(16);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    std::vector<double> input(size_t(1) << 20);
+    for (double& value : input) {
+        value = distribution(generator);
+    }
+
+    SlidingWindowTimeTestRun<16>(input);
+    SlidingWindowTimeTestRun<256>(input);
+    SlidingWindowTimeTestRun<4096>(input);
+    SlidingWindowTimeTestRun<65536>(input);
+    SlidingWindowTimeTestRun<1048576>(input);
+}
+
+namespace {
+template<typename T, size_t _Capacity>
+void SimdReductionsCheck(size_t size, size_t shift) {
+    std::mt19937 generator(static_cast<unsigned>(size * 31 + shift));
+    auto a = std::make_unique<CircularBufferArray<T, _Capacity, int>>();
+    auto b = std::make_unique<CircularBufferArray<T, _Capacity, int>>();
+    auto next = [&generator]() {
+        if constexpr (std::is_integral_v<T>) {
+            return static_cast<T>(std::uniform_int_distribution<int>(-100000, 100000)(generator));
+        } else {
+            return static_cast<T>(std::uniform_real_distribution<double>(-1.0, 1.0)(generator));
+        }
+    };
+    // Shifting by different amounts gives the two buffers different wrap points
+    for (size_t i = 0; i < shift; ++i) {
+        a->PushBack(T());
+    }
+    for (size_t i = 0; i < shift / 2; ++i) {
+        b->PushBack(T());
+    }
+    for (size_t i = 0; i < size; ++i) {
+        a->PushBack(next());
+        b->PushBack(next());
+    }
+    while (a->Size() > size) a->PopFront();
+    while (b->Size() > size) b->PopFront();
+
+    using sum_t = simd::sum_type<T>;
+    const sum_t sum = std::accumulate(a->begin(), a->end(), sum_t(0));
+    const sum_t dot = std::inner_product(a->begin(), a->end(), b->begin(), sum_t(0),
+                                         std::plus<sum_t>(), [](T x, T y) { return static_cast<sum_t>(x) * y; });
+    const T threshold = T();
+    const size_t greater = std::count_if(a->begin(), a->end(), [threshold](T x) { return x > threshold; });
+    const double tolerance = std::is_same_v<T, float> ? 1e-3 : 1e-9;
+
+    for (simd::Level level : {simd::Level::Scalar, simd::Level::Sse2, simd::Level::Avx2}) {
+        if constexpr (std::is_integral_v<T>) {
+            ASSERT(simd::Sum(*a, level) == sum);
+            ASSERT(simd::Dot(*a, *b, level) == dot);
+        } else {
+            ASSERT(std::abs(simd::Sum(*a, level) - sum) <= tolerance * std::max<double>(1.0, size));
+            ASSERT(std::abs(simd::Dot(*a, *b, level) - dot) <= tolerance * std::max<double>(1.0, size));
+        }
+        ASSERT(simd::CountGreater(*a, threshold, level) == greater);
+        if (size != 0) {
+            ASSERT(simd::Min(*a, level) == *std::min_element(a->begin(), a->end()));
+            ASSERT(simd::Max(*a, level) == *std::max_element(a->begin(), a->end()));
+        }
+    }
+}
+
+template<typename T>
+void SimdReductionsCheckSizes() {
+    for (size_t size : {size_t(0), size_t(1), size_t(3), size_t(7), size_t(17), size_t(100), size_t(1000)}) {
+        for (size_t shift : {size_t(0), size_t(5), size_t(333), size_t(999)}) {
+            SimdReductionsCheck<T, 1000>(size, shift);
+        }
+    }
+    SimdReductionsCheck<T, 4096>(4096, 1234);
+}
+}
+
+void SimdReductions() {
+    SimdReductionsCheckSizes<int32_t>();
+    SimdReductionsCheckSizes<float>();
+    SimdReductionsCheckSizes<double>();
+
+    // Stack storage and element extremes
+    CircularBufferArray<int32_t, 16> a;
+    CircularBufferArray<int32_t, 16> signs;
+    for (int i = 0; i < 20; ++i) {
+        a.PushBack(i % 2 ? INT32_MAX : INT32_MIN);
+        signs.PushBack(i % 2 ? 1 : -1);
+    }
+    ASSERT(simd::Sum(a) == 8LL * INT32_MAX + 8LL * INT32_MIN);
+    // Products do not fit in 32 bits
+    ASSERT(simd::Dot(a, signs) == 8LL * INT32_MAX - 8LL * INT32_MIN);
+    ASSERT(simd::Min(a) == INT32_MIN && simd::Max(a) == INT32_MAX);
+    ASSERT(simd::CountGreater(a, 0) == 8);
+}
+
+namespace {
+template<typename T, size_t _Capacity>
+void SimdReductionsTimeTestRun(const char* type_name) {
+    auto a = std::make_unique<CircularBufferArray<T, _Capacity, int>>();
+    auto b = std::make_unique<CircularBufferArray<T, _Capacity, int>>();
+    for (size_t i = 0; i < _Capacity + _Capacity / 3; ++i) {
+        a->PushBack(static_cast<T>(i % 1000));
+        b->PushBack(static_cast<T>(i % 7));
+    }
+    const size_t rounds = std::max<size_t>(1, (size_t(1) << 24) / _Capacity);
+    const char* level_names[] = {"Scalar", "Sse2", "Avx2"};
+
+    for (simd::Level level : {simd::Level::Scalar, simd::Level::Sse2, simd::Level::Avx2}) {
+        if (level > simd::GetLevel()) continue;
+        double checksum = 0;
+        auto run = [&](const char* name, auto&& func) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t r = 0; r < rounds; ++r) {
+                checksum += static_cast<double>(func());
+            }
+            std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+            std::cout << "Time taken by " << name << "_" << type_name << "_" << _Capacity << "_"
+                      << level_names[static_cast<int>(level)] << ": " << duration.count() << " seconds" << std::endl;
+        };
+        run("Sum", [&]() { return simd::Sum(*a, level); });
+        run("Dot", [&]() { return simd::Dot(*a, *b, level); });
+        run("Min", [&]() { return simd::Min(*a, level); });
+        run("CountGreater", [&]() { return simd::CountGreater(*a, T(500), level); });
+        if (checksum == 0) std::cout << checksum << std::endl;
+    }
+}
+}
+
+void SimdReductionsTimeTest() {
+    SimdReductionsTimeTestRun<int32_t, 1024>("int32");
+    SimdReductionsTimeTestRun<int32_t, 1048576>("int32");
+    SimdReductionsTimeTestRun<float, 1024>("float");
+    SimdReductionsTimeTestRun<float, 1048576>("float");
+    SimdReductionsTimeTestRun<double, 1024>("double");
+    SimdReductionsTimeTestRun<double, 1048576>("double");
+}
+
+void TimeWindowBufferMethods() {
+    using time_point = std::chrono::steady_clock::time_point;
+    using std::chrono::milliseconds;
+    auto at = [](long long ms) {
+        return time_point(milliseconds(ms));
+    };
+    std::mt19937 generator(18);
+    std::uniform_int_distribution<int> gap(0, 30);
+
+    auto check = [&](auto& a, long long window) {
+        std::vector<std::pair<long long, int>> pushed;
+        long long now = 1000;
+        for (int i = 0; i < 3000; ++i) {
+            now += gap(generator);
+            a.PushBack(at(now), i);
+            pushed.emplace_back(now, i);
+
+            // Reference: samples younger than the window, at most Capacity of them
+            std::vector<std::pair<long long, int>> expected;
+            for (const auto& sample : pushed) {
+                if (sample.first > now - window) expected.push_back(sample);
+            }
+            if (expected.size() > a.Capacity()) {
+                expected.erase(expected.begin(), expected.end() - a.Capacity());
+            }
+            ASSERT(a.Size() == expected.size());
+            ASSERT(a.GetFront().value == expected.front().second && a.GetBack().value == expected.back().second);
+
+            const long long from = now - gap(generator) * 5;
+            const long long to = from + gap(generator) * 3;
+            size_t count = 0;
+            for (const auto& sample : expected) {
+                if (from <= sample.first && sample.first < to) ++count;
+            }
+            ASSERT(a.CountInRange(at(from), at(to)) == count);
+            size_t lower = 0;
+            while (lower < expected.size() && expected[lower].first < from) ++lower;
+            size_t upper = 0;
+            while (upper < expected.size() && expected[upper].first <= from) ++upper;
+            ASSERT(a.LowerBound(at(from)) == lower && a.UpperBound(at(from)) == upper);
+
+            size_t visited = 0;
+            a.ForEachInRange(at(from), at(to), [&](const auto& sample) {
+                ASSERT(sample.value == expected[lower + visited].second);
+                ++visited;
+            });
+            ASSERT(visited == count);
+        }
+    };
+
+    //StackAllocator
+    {
+        TimeWindowBuffer<int, 64> a(milliseconds(500));
+        check(a, 500);
+    }
+
+    //HeapAllocator
+    {
+        TimeWindowBuffer<int, 20000, std::chrono::steady_clock, int> a(milliseconds(500));
+        check(a, 500);
+    }
+
+    // Expire without pushes
+    {
+        TimeWindowBuffer<int, 16> a(milliseconds(100));
+        a.PushBack(at(0), 1);
+        a.PushBack(at(50), 2);
+        a.PushBack(at(99), 3);
+        ASSERT(a.Expire(at(99)) == 0 && a.Size() == 3);
+        ASSERT(a.Expire(at(100)) == 1 && a.GetFront().value == 2);
+        ASSERT(a.Expire(at(1000)) == 2 && a.IsEmpty());
+        ASSERT(a.CountInRange(at(0), at(1000)) == 0 && a.LowerBound(at(0)) == 0);
+    }
+
+    // Downsample and Resample
+    {
+        TimeWindowBuffer<int, 16> a(milliseconds(1000));
+        for (int i = 0; i < 10; ++i) {
+            a.PushBack(at(100 + i * 10), i);
+        }
+        TimeBucket<int> buckets[4];
+        a.Downsample(at(100), milliseconds(30), 4, buckets);
+        ASSERT(buckets[0].count == 3 && buckets[0].sum == 3 && buckets[0].min == 0 && buckets[0].max == 2);
+        ASSERT(buckets[1].count == 3 && buckets[1].Mean() == 4);
+        ASSERT(buckets[3].count == 1 && buckets[3].min == 9 && buckets[3].max == 9);
+        ASSERT(buckets[2].start == at(160));
+        a.Downsample(at(0), milliseconds(25), 4, buckets);
+        ASSERT(buckets[0].count == 0 && buckets[3].count == 0 && buckets[0].Mean() == 0);
+
+        int resampled[5];
+        a.Resample(at(85), milliseconds(15), 5, resampled, -1);
+        ASSERT(resampled[0] == -1 && resampled[1] == 0 && resampled[2] == 1);
+        ASSERT(resampled[3] == 3 && resampled[4] == 4);
+        a.Resample(at(500), milliseconds(1), 2, resampled);
+        ASSERT(resampled[0] == 9 && resampled[1] == 9);
+    }
+}
+
+namespace {
+template<size_t _Capacity>
+void TimeWindowTimeTestRun(long long events_per_second) {
+    using time_point = std::chrono::steady_clock::time_point;
+    const auto window = std::chrono::milliseconds(500);
+    const auto step = std::chrono::nanoseconds(1000000000LL / events_per_second);
+    const size_t pushes = size_t(1) << 22;
+    const std::string name = std::to_string(events_per_second / 1000) + "K_per_s";
+
+    auto a = std::make_unique<TimeWindowBuffer<double, _Capacity, std::chrono::steady_clock, int>>(window);
+    time_point now;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < pushes; ++i) {
+        now += step;
+        a->PushBack(now, static_cast<double>(i));
+    }
+    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+    std::cout << "Time per push of TimeWindow_Push_" << name << ": "
+              << duration.count() * 1e9 / static_cast<double>(pushes) << " ns" << std::endl;
+
+    // Queries of the last 1 ms, 50 ms and the whole window
+    std::mt19937 generator(18);
+    std::uniform_int_distribution<long long> offset(0, window.count() * 1000000LL);
+    double checksum = 0;
+    for (auto span : {std::chrono::milliseconds(1), std::chrono::milliseconds(50), window}) {
+        const int queries = 2000;
+        std::vector<long long> latencies;
+        latencies.reserve(queries);
+        for (int i = 0; i < queries; ++i) {
+            const time_point from = now - std::chrono::nanoseconds(offset(generator));
+            auto query_start = std::chrono::steady_clock::now();
+            double sum = 0;
+            a->ForEachInRange(from, from + span, [&sum](const auto& sample) { sum += sample.value; });
+            latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - query_start).count());
+            checksum += sum;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) {
+            return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+        };
+        std::cout << "Latency of TimeWindow_Range_" << span.count() << "ms_" << name << ": p50="
+                  << percentile(0.5) << " p99=" << percentile(0.99) << " ns" << std::endl;
+    }
+
+    std::vector<TimeBucket<double>> buckets(500);
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < 16; ++i) {
+        a->Downsample(now - window, std::chrono::milliseconds(1), buckets.size(), buckets.data());
+        checksum += buckets.back().sum;
+    }
+    duration = std::chrono::high_resolution_clock::now() - start;
+    std::cout << "Time taken by TimeWindow_Downsample_" << name << ": " << duration.count() / 16 << " seconds" << std::endl;
+    if (checksum == 0) std::cout << checksum << std::endl;
+}
+}
+
+void TimeWindowTimeTest() {
+    TimeWindowTimeTestRun<65536>(100000);
+    TimeWindowTimeTestRun<1048576>(1000000);
+    TimeWindowTimeTestRun<1048576>(2000000);
+}
+
+void HybridSortDistributions() {
+    std::mt19937 generator(21);
+    auto check = [](std::vector<int> nums) {
+        std::vector<int> expected = nums;
+        std::sort(expected.begin(), expected.end());
+        HybridSort(nums);
+        ASSERT(nums == expected);
+    };
+
+    check({});
+    check({42});
+    check({3, 3, 3});
+    check({INT32_MAX, INT32_MIN, 0, -1, 1, INT32_MIN, INT32_MAX});
+    check({4, 2, 5, -4, -6, 7, 1, 2, 8, 9, -1, 8, 3, 2, 1});
+
+    for (size_t size : {size_t(2), size_t(100), size_t(10000), size_t(200000)}) {
+        std::vector<int> nums(size);
+
+        // Narrow range, counting sort
+        std::uniform_int_distribution<int> narrow(-50, 50);
+        for (int& n : nums) n = narrow(generator);
+        check(nums);
+
+        // Full range, radix sort
+        std::uniform_int_distribution<int> wide(INT32_MIN, INT32_MAX);
+        for (int& n : nums) n = wide(generator);
+        check(nums);
+
+        // Narrow range with outliers, radix sort
+        for (size_t i = 0; i < size; ++i) {
+            nums[i] = i % 97 == 0 ? (i % 2 ? INT32_MAX : INT32_MIN) : narrow(generator);
+        }
+        check(nums);
+
+        // Sorted and reversed
+        std::sort(nums.begin(), nums.end());
+        check(nums);
+        std::reverse(nums.begin(), nums.end());
+        check(nums);
+    }
+}
+
+namespace {
+template<typename T, unsigned _DigitBits>
+void RadixSortCheck(RadixSorter<T, _DigitBits>& sorter, std::vector<T> values) {
+    std::vector<T> expected = values;
+    std::sort(expected.begin(), expected.end());
+    sorter.Sort(values);
+    ASSERT(values == expected);
+}
+
+template<typename T>
+void RadixSortCheckType() {
+    std::mt19937_64 generator(22);
+    auto next = [&generator]() {
+        if constexpr (std::is_integral_v<T>) {
+            return static_cast<T>(generator());
+        } else {
+            return static_cast<T>(std::uniform_real_distribution<double>(-1e6, 1e6)(generator));
+        }
+    };
+    std::vector<T> extremes = {std::numeric_limits<T>::max(), std::numeric_limits<T>::lowest(), T(0), T(1),
+                               std::numeric_limits<T>::min(), T(1), T(0)};
+    if constexpr (std::is_floating_point_v<T>) {
+        extremes.push_back(-T(0));
+        extremes.push_back(std::numeric_limits<T>::infinity());
+        extremes.push_back(-std::numeric_limits<T>::infinity());
+        extremes.push_back(std::numeric_limits<T>::denorm_min());
+        extremes.push_back(-std::numeric_limits<T>::denorm_min());
+    } else if constexpr (std::is_signed_v<T>) {
+        extremes.push_back(T(-1));
+    }
+
+    RadixSorter<T> sorter;
+    RadixSorter<T, 11> sorter_11;
+    RadixSortCheck(sorter, {});
+    RadixSortCheck(sorter, extremes);
+    RadixSortCheck(sorter_11, extremes);
+    for (size_t size : {size_t(1), size_t(2), size_t(1000), size_t(100000), size_t(333)}) {
+        std::vector<T> values(size);
+        for (T& value : values) value = next();
+        RadixSortCheck(sorter, values);
+        RadixSortCheck(sorter_11, values);
+
+        // Small values share the high digits, those passes are skipped
+        for (T& value : values) value = static_cast<T>(static_cast<int>(next()) % 100);
+        RadixSortCheck(sorter, values);
+        RadixSortCheck(sorter_11, values);
+    }
+}
+}
+
+void RadixSortTypes() {
+    RadixSortCheckType<int32_t>();
+    RadixSortCheckType<int64_t>();
+    RadixSortCheckType<uint32_t>();
+    RadixSortCheckType<uint64_t>();
+    RadixSortCheckType<float>();
+    RadixSortCheckType<double>();
+    RadixSortCheckType<int16_t>();
+
+    // Key mapping orders -0.0 before +0.0
+    std::vector<double> zeros = {0.0, -0.0, 0.0, -0.0};
+    RadixSort(zeros);
+    ASSERT(std::signbit(zeros[0]) && std::signbit(zeros[1]) && !std::signbit(zeros[2]) && !std::signbit(zeros[3]));
+}
+
+void ParallelSortThreads() {
+    std::mt19937_64 generator(23);
+    std::uniform_int_distribution<int> narrow(-500, 500);
+    for (size_t thread_count : {size_t(1), size_t(2), size_t(3), size_t(8)}) {
+        for (size_t size : {size_t(0), size_t(1), size_t(5), size_t(1000), size_t(100003)}) {
+            std::vector<int> wide(size);
+            std::vector<double> reals(size);
+            std::vector<int> narrow_values(size);
+            std::vector<int> outliers(size);
+            for (size_t i = 0; i < size; ++i) {
+                wide[i] = static_cast<int>(generator());
+                reals[i] = std::uniform_real_distribution<double>(-1e3, 1e3)(generator);
+                narrow_values[i] = narrow(generator);
+                outliers[i] = i % 101 == 0 ? static_cast<int>(generator()) : narrow(generator);
+            }
+
+            // Threshold 0 makes even small arrays go through the threads
+            auto check_radix = [thread_count](auto values) {
+                auto expected = values;
+                std::sort(expected.begin(), expected.end());
+                ParallelRadixSorter<typename decltype(values)::value_type> sorter(thread_count, 0);
+                sorter.Sort(values);
+                ASSERT(values == expected);
+            };
+            check_radix(wide);
+            check_radix(reals);
+            check_radix(narrow_values);
+
+            auto check_hybrid = [thread_count](std::vector<int> values, size_t min_parallel_size) {
+                std::vector<int> expected = values;
+                std::sort(expected.begin(), expected.end());
+                ParallelHybridSort(values, thread_count, min_parallel_size);
+                ASSERT(values == expected);
+            };
+            for (size_t min_parallel_size : {size_t(0), parallel_sort_min_size}) {
+                check_hybrid(wide, min_parallel_size);
+                check_hybrid(narrow_values, min_parallel_size);
+                check_hybrid(outliers, min_parallel_size);
+            }
+        }
+    }
+
+    // Sorter is reused across sizes with one scratch buffer
+    ParallelRadixSorter<uint64_t, 11> sorter(4, 0);
+    for (size_t size : {size_t(50000), size_t(10), size_t(70000)}) {
+        std::vector<uint64_t> values(size);
+        for (uint64_t& value : values) value = generator() >> (size % 7);
+        std::vector<uint64_t> expected = values;
+        std::sort(expected.begin(), expected.end());
+        sorter.Sort(values);
+        ASSERT(values == expected);
+    }
+    ASSERT(sorter.ThreadCount() == 4);
+
+    // Passes where every key has the same digit are skipped, as in RadixSorter
+    for (size_t thread_count : {size_t(2), size_t(3), size_t(8)}) {
+        ParallelRadixSorter<uint32_t> small_sorter(thread_count, 0);
+        std::vector<uint32_t> values(10007);
+        for (uint32_t& value : values) value = static_cast<uint32_t>(generator() % 256);
+        std::vector<uint32_t> expected = values;
+        std::sort(expected.begin(), expected.end());
+        small_sorter.Sort(values);
+        ASSERT(values == expected);
+        ASSERT(small_sorter.ScatteredPassCount() == 1);
+        small_sorter.Sort(values);
+        ASSERT(values == expected);
+
+        for (uint32_t& value : values) value = static_cast<uint32_t>(generator() % 65536) << 8;
+        expected = values;
+        std::sort(expected.begin(), expected.end());
+        small_sorter.Sort(values);
+        ASSERT(values == expected);
+        ASSERT(small_sorter.ScatteredPassCount() == 2);
+    }
+}
+
+namespace {
+struct SmallRecord {
+    int16_t key;
+    uint32_t sequence;
+};
+
+struct NamedRecord {
+    double key;
+    size_t sequence;
+    std::string name;
+};
+}
+
+void SortByKeyStable() {
+    std::mt19937 generator(24);
+    std::uniform_int_distribution<int> keys(-20, 20);
+
+    auto check = [](const auto& records, const auto& sorted) {
+        ASSERT(records.size() == sorted.size());
+        for (size_t i = 1; i < sorted.size(); ++i) {
+            ASSERT(sorted[i - 1].key < sorted[i].key
+                   || (sorted[i - 1].key == sorted[i].key && sorted[i - 1].sequence < sorted[i].sequence));
+        }
+    };
+
+    for (size_t size : {size_t(0), size_t(1), size_t(2), size_t(100), size_t(50000)}) {
+        // Small trivially copyable records, sorted directly
+        std::vector<SmallRecord> small(size);
+        for (size_t i = 0; i < size; ++i) {
+            small[i] = {static_cast<int16_t>(keys(generator)), static_cast<uint32_t>(i)};
+        }
+        std::vector<SmallRecord> small_sorted = small;
+        SortByKey(small_sorted, [](const SmallRecord& record) { return record.key; });
+        check(small, small_sorted);
+
+        // Records with a payload, sorted through the permutation
+        std::vector<NamedRecord> named(size);
+        for (size_t i = 0; i < size; ++i) {
+            named[i] = {keys(generator) * 0.5, i, std::to_string(i)};
+        }
+        std::vector<NamedRecord> named_sorted = named;
+        SortByKey(named_sorted, [](const NamedRecord& record) { return record.key; });
+        check(named, named_sorted);
+        for (const NamedRecord& record : named_sorted) {
+            ASSERT(record.name == std::to_string(record.sequence));
+        }
+
+        // Argsort leaves the records as they are
+        const std::vector<size_t> permutation = Argsort(named, [](const NamedRecord& record) { return record.key; });
+        ASSERT(permutation.size() == size);
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT(named[permutation[i]].sequence == named_sorted[i].sequence);
+            ASSERT(named[i].sequence == i);
+        }
+    }
+
+    // Move-only records
+    std::vector<std::unique_ptr<int>> pointers;
+    for (int value : {5, -3, 5, 0, -3}) {
+        pointers.push_back(std::make_unique<int>(value));
+    }
+    const int* first_five = pointers[0].get();
+    SortByKey(pointers, [](const std::unique_ptr<int>& pointer) { return *pointer; });
+    ASSERT(*pointers[0] == -3 && *pointers[1] == -3 && *pointers[2] == 0 && *pointers[3] == 5);
+    ASSERT(pointers[3].get() == first_five);
+}
+
+void SortHistogramKernels() {
+    std::mt19937 generator(25);
+    auto check = [](const std::vector<int>& nums, int lo, size_t range) {
+        std::vector<size_t> expected(range, 0);
+        for (int n : nums) ++expected[static_cast<size_t>(static_cast<int64_t>(n) - lo)];
+        auto bucket = [lo](int value) { return static_cast<size_t>(static_cast<int64_t>(value) - lo); };
+        std::vector<size_t> histogram(range, 7);
+        BuildHistogram<1>(nums.data(), nums.size(), range, histogram.data(), bucket);
+        ASSERT(histogram == expected);
+        std::fill(histogram.begin(), histogram.end(), 7);
+        BuildHistogram<4>(nums.data(), nums.size(), range, histogram.data(), bucket);
+        ASSERT(histogram == expected);
+        std::fill(histogram.begin(), histogram.end(), 7);
+        BuildHistogram<3>(nums.data(), nums.size(), range, histogram.data(), bucket);
+        ASSERT(histogram == expected);
+        // Caller owned scratch, reused without clearing
+        std::vector<uint32_t> scratch(GetHistogramScratchSize(range), 5);
+        for (int repeat = 0; repeat < 2; ++repeat) {
+            std::fill(histogram.begin(), histogram.end(), 7);
+            BuildHistogram(nums.data(), nums.size(), range, histogram.data(), scratch.data(), bucket);
+            ASSERT(histogram == expected);
+        }
+
+        if (nums.empty()) return;
+        const auto [min_it, max_it] = std::minmax_element(nums.begin(), nums.end());
+        for (simd::Level level : {simd::Level::Scalar, simd::Level::Sse2, simd::Level::Avx2}) {
+            const auto [min, max] = simd::MinMax(nums.data(), nums.size(), level);
+            ASSERT(min == *min_it);
+            ASSERT(max == *max_it);
+        }
+    };
+
+    check({}, 0, 4);
+    check({2}, 0, 4);
+    check({-3, 5, -3, -3, 5, 0, 1}, -3, 9);
+
+    // Every size around the vector widths and the sub-histogram count, extremes at every position
+    for (size_t size = 1; size <= 40; ++size) {
+        std::vector<int> nums(size, 0);
+        for (size_t position = 0; position < size; ++position) {
+            nums.assign(size, 0);
+            nums[(position + 1) % size] = INT32_MAX;
+            nums[position] = INT32_MIN;
+            const auto [min, max] = simd::MinMax(nums.data(), size);
+            ASSERT(min == INT32_MIN);
+            ASSERT(max == (size == 1 ? INT32_MIN : INT32_MAX));
+        }
+        std::uniform_int_distribution<int> narrow(-20, 20);
+        for (int& n : nums) n = narrow(generator);
+        check(nums, -20, 41);
+    }
+
+    ASSERT(GetHistogramScratchSize(256) != 0);
+    ASSERT(GetHistogramScratchSize(256, 1) == 0);
+    ASSERT(GetHistogramScratchSize(histogram_sub_max_buckets + 1) == 0);
+
+    // Runs of equal values, and ranges below and above histogram_sub_max_buckets
+    for (size_t range : {size_t(1), size_t(256), histogram_sub_max_buckets + 1}) {
+        std::vector<int> nums(100003);
+        std::uniform_int_distribution<int> values(0, static_cast<int>(range) - 1);
+        for (int& n : nums) n = values(generator) - 1000;
+        check(nums, -1000, range);
+        std::sort(nums.begin(), nums.end());
+        check(nums, -1000, range);
+    }
 
-    TIME_DIF(StackAllocator_128)
-    TIME_DIF(HeapAllocator_128)
-    TIME_DIF(StackAllocator_1024)
-    TIME_DIF(HeapAllocatorMax_1025)
-    TIME_DIF(HeapAllocator_1024)
-    TIME_DIF(StackAllocator_LageDataStruct_32)
-    TIME_DIF(HeapAllocator_LageDataStruct_32)
+    // CountingSort counts relative to the minimum, values near the limits need a small catalog only
+    std::vector<int> nums = {INT32_MAX - 2, INT32_MAX, INT32_MAX - 1, INT32_MAX, INT32_MAX - 2};
+    std::vector<int> expected = nums;
+    std::sort(expected.begin(), expected.end());
+    CountingSort(nums);
+    ASSERT(nums == expected);
+    nums = {INT32_MIN + 1, INT32_MIN, INT32_MIN + 3, INT32_MIN + 1};
+    expected = nums;
+    std::sort(expected.begin(), expected.end());
+    CountingSort(nums);
+    ASSERT(nums == expected);
 }
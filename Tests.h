@@ -24,4 +24,57 @@ void CircBufferIteratorOperatorAssignment();
 void CircBufferIteratorOperatorIncrement();
 void CircBufferIteratorOperatorEquality();
 void CircBufferIteration();
-void CircBufferTimeTest();
\ No newline at end of file
+void CircBufferIterationWrapped();
+void CircBufferPowerOfTwoCapacity();
+void SpscBufferTryPushTryPop();
+void SpscBufferTwoThreads();
+void SpscBufferTimeTest();
+void MpmcBufferTryPushTryPop();
+void MpmcBufferThrowingElement();
+void MpmcBufferManyThreads();
+void MpmcBufferTimeTest();
+void RuntimeCircBufferConstruct();
+void RuntimeCircBufferMethods();
+void RuntimeCircBufferReserve();
+void RuntimeCircBufferResize();
+void RuntimeCircBufferShrinkToFit();
+void CircBufferStandardAllocator();
+void RuntimeCircBufferStandardAllocator();
+void CircBufferAllocatorTimeTest();
+void CircBufferMethodPushBackRange();
+void CircBufferMethodPopFrontInto();
+void CircBufferBulkTimeTest();
+void CircBufferMethodArrayOneArrayTwo();
+void CircBufferMethodLinearize();
+void CircBufferIteratorRandomAccess();
+void CircBufferIteratorAlgorithms();
+void CircBufferAlgorithmTimeTest();
+void CircBufferMethodForEach();
+void CircBufferForEachTimeTest();
+void BlockingBufferPushPop();
+void BlockingBufferTwoThreads();
+void BlockingBufferTimeTest();
+void CircBufferOverflowPolicy();
+void RuntimeCircBufferOverflowPolicy();
+void CircBufferOverflowPolicyTimeTest();
+void MappedCircBufferRecover();
+void MappedCircBufferTimeTest();
+void SharedSpscBufferTwoProcesses();
+void SharedSpscBufferTimeTest();
+void CircBufferAlignment();
+void ConcurrentBufferPaddedSlots();
+void CircBufferAlignmentTimeTest();
+void CircBufferMoveOnly();
+void CircBufferExceptionSafety();
+void SlidingWindowStatsMethods();
+void SlidingWindowAggregatorMethods();
+void SlidingWindowTimeTest();
+void SimdReductions();
+void SimdReductionsTimeTest();
+void TimeWindowBufferMethods();
+void TimeWindowTimeTest();
+void HybridSortDistributions();
+void RadixSortTypes();
+void ParallelSortThreads();
+void SortByKeyStable();
+void SortHistogramKernels();
\ No newline at end of file
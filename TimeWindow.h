@@ -0,0 +1,269 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <chrono>
+#include <type_traits>
+#include <utility>
+
+#include "CircularBuffer.h"
+
+/**
+ *  @brief Value with the time it was taken at.
+*/
+template<typename T, typename Clock = std::chrono::steady_clock>
+struct TimedSample {
+    typename Clock::time_point time;
+    T value;
+};
+
+/**
+ *  @brief Aggregates of the samples that fell into one bucket of TimeWindowBuffer::Downsample.
+ *  "min" and "max" are meaningful only when "count" is not 0.
+*/
+template<typename T, typename Clock = std::chrono::steady_clock>
+struct TimeBucket {
+    typename Clock::time_point start;
+    std::size_t count = 0;
+    double sum = 0;
+    T min{};
+    T max{};
+
+    /**
+     *  @brief Returns mean of the samples in the bucket, 0 for an empty bucket.
+    */
+    inline double Mean() const {
+        return count == 0 ? 0.0 : sum / static_cast<double>(count);
+    }
+};
+
+/**
+ *  @brief Samples of the last "window" of time
+ *  Samples are pushed in non-decreasing time order into a CircularBufferArray, so they are sorted by time
+ *  in both contiguous segments of the ring. Push evicts the samples that are older than "window" relative to
+ *  the pushed one, range queries find their bounds with a binary search in the segment holding the time.
+ *  "_Capacity" bounds the memory, when the rate is higher than "_Capacity" per window the oldest samples are
+ *  overwritten before they expire.
+ *  @tparam T Type
+ *  @tparam Capacity Max count of samples kept
+ *  @tparam Clock Clock of the timestamps
+ *  @tparam IsHeap Storage selection of the underlying CircularBufferArray
+*/
+template<typename T, std::size_t _Capacity, typename Clock = std::chrono::steady_clock, typename IsHeap = bool>
+class TimeWindowBuffer {
+public:
+    using value_type = TimedSample<T, Clock>;
+    using time_point = typename Clock::time_point;
+    using duration = typename Clock::duration;
+    using bucket_type = TimeBucket<T, Clock>;
+
+private:
+    CircularBufferArray<value_type, _Capacity, IsHeap> samples_;
+    duration window_;
+
+    // Index of the first sample for which "is_before(sample time)" is false.
+    template<typename IsBefore>
+    inline std::size_t Partition(IsBefore is_before) const {
+        const auto one = samples_.ArrayOne();
+        const auto two = samples_.ArrayTwo();
+        auto predicate = [&is_before](const value_type& sample) {
+            return is_before(sample.time);
+        };
+        if (two.second != 0 && is_before(two.first->time)) {
+            return one.second + (std::partition_point(two.first, two.first + two.second, predicate) - two.first);
+        }
+        return std::partition_point(one.first, one.first + one.second, predicate) - one.first;
+    }
+
+    // Call "func(sample)" for the samples with indexes [first, last), one pointer loop per segment.
+    template<typename Func>
+    inline void ForEachIndex(std::size_t first, std::size_t last, Func&& func) const {
+        std::size_t offset = 0;
+        samples_.ForEachSegment([&](const value_type* data, std::size_t size) {
+            const std::size_t begin = std::max(first, offset);
+            const std::size_t end = std::min(last, offset + size);
+            for (std::size_t i = begin; i < end; ++i) {
+                func(data[i - offset]);
+            }
+            offset += size;
+        });
+    }
+
+public:
+    explicit TimeWindowBuffer(duration window) : window_(window) {
+        assert(window > duration::zero() && "Window must be positive");
+    }
+
+    /**
+     *  @brief Push sample at the back, samples that are "window" or more older than "time" are evicted.
+     *  "time" must not be less than the time of the back sample.
+    */
+    inline void PushBack(time_point time, const T& value) {
+        assert((IsEmpty() || !(time < samples_.GetBack().time)) && "Samples must be pushed in time order");
+        Expire(time);
+        samples_.PushBack(value_type{time, value});
+    }
+
+    /**
+     *  @brief Evict samples that are "window" or more older than "now".
+     *  @return Count of evicted samples.
+    */
+    inline std::size_t Expire(time_point now) {
+        const time_point oldest_kept = now - window_;
+        std::size_t evicted = 0;
+        while (!samples_.IsEmpty() && !(oldest_kept < samples_.GetFront().time)) {
+            samples_.PopFront();
+            ++evicted;
+        }
+        return evicted;
+    }
+
+    /**
+     *  @brief Returns index of the first sample whose time is not less than "time", Size if there is none.
+    */
+    inline std::size_t LowerBound(time_point time) const {
+        return Partition([time](time_point sample_time) { return sample_time < time; });
+    }
+
+    /**
+     *  @brief Returns index of the first sample whose time is greater than "time", Size if there is none.
+    */
+    inline std::size_t UpperBound(time_point time) const {
+        return Partition([time](time_point sample_time) { return !(time < sample_time); });
+    }
+
+    /**
+     *  @brief Returns indexes [first, last) of the samples taken in [from, to).
+    */
+    inline std::pair<std::size_t, std::size_t> Range(time_point from, time_point to) const {
+        const std::size_t first = LowerBound(from);
+        return {first, std::max(first, LowerBound(to))};
+    }
+
+    /**
+     *  @brief Returns count of the samples taken in [from, to).
+    */
+    inline std::size_t CountInRange(time_point from, time_point to) const {
+        const auto range = Range(from, to);
+        return range.second - range.first;
+    }
+
+    /**
+     *  @brief Call "func(sample)" for each sample taken in [from, to), from the oldest.
+    */
+    template<typename Func>
+    inline void ForEachInRange(time_point from, time_point to, Func&& func) const {
+        const auto range = Range(from, to);
+        ForEachIndex(range.first, range.second, func);
+    }
+
+    /**
+     *  @brief Aggregate the samples taken in [from, from + bucket_count * bucket_width) into "bucket_count"
+     *  buckets of "bucket_width", written to "out". Buckets with no samples have "count" 0.
+    */
+    inline void Downsample(time_point from, duration bucket_width, std::size_t bucket_count, bucket_type* out) const {
+        static_assert(std::is_arithmetic_v<T>, "Downsample requires arithmetic T");
+        assert(bucket_width > duration::zero() && "Bucket width must be positive");
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            out[i] = bucket_type{};
+            out[i].start = from + bucket_width * static_cast<typename duration::rep>(i);
+        }
+        const auto to = from + bucket_width * static_cast<typename duration::rep>(bucket_count);
+        ForEachInRange(from, to, [&](const value_type& sample) {
+            bucket_type& bucket = out[static_cast<std::size_t>((sample.time - from) / bucket_width)];
+            if (bucket.count == 0) {
+                bucket.min = sample.value;
+                bucket.max = sample.value;
+            } else {
+                bucket.min = std::min(bucket.min, sample.value);
+                bucket.max = std::max(bucket.max, sample.value);
+            }
+            bucket.sum += static_cast<double>(sample.value);
+            ++bucket.count;
+        });
+    }
+
+    /**
+     *  @brief Resample onto the grid from, from + step, ... of "count" points written to "out".
+     *  Each point takes the value of the last sample taken at or before it, "fill" if there is none.
+    */
+    inline void Resample(time_point from, duration step, std::size_t count, T* out, const T& fill = T()) const {
+        assert(step > duration::zero() && "Step must be positive");
+        std::size_t next = UpperBound(from);
+        for (std::size_t i = 0; i < count; ++i) {
+            const time_point point = from + step * static_cast<typename duration::rep>(i);
+            while (next < Size() && !(point < samples_[next].time)) {
+                ++next;
+            }
+            out[i] = next == 0 ? fill : samples_[next - 1].value;
+        }
+    }
+
+    /**
+     *  @brief Returns a reference to the oldest sample.
+    */
+    inline const value_type& GetFront() const {
+        return samples_.GetFront();
+    }
+
+    /**
+     *  @brief Returns a reference to the newest sample.
+    */
+    inline const value_type& GetBack() const {
+        return samples_.GetBack();
+    }
+
+    /**
+     *  @brief Returns the samples, front is the oldest.
+    */
+    inline const CircularBufferArray<value_type, _Capacity, IsHeap>& Samples() const {
+        return samples_;
+    }
+
+    /**
+     *  @brief Returns the window duration.
+    */
+    inline duration Window() const {
+        return window_;
+    }
+
+    /**
+     *  @brief Returns count of samples.
+    */
+    inline std::size_t Size() const {
+        return samples_.Size();
+    }
+
+    /**
+     *  @brief Returns Capacity of the container.
+    */
+    inline std::size_t Capacity() const {
+        return _Capacity;
+    }
+
+    /**
+     *  @brief Erase all samples.
+    */
+    inline void Clear() {
+        samples_.Clear();
+    }
+
+    /**
+     *  @brief Returns true if there are no samples.
+    */
+    inline bool IsEmpty() const {
+        return samples_.IsEmpty();
+    }
+
+    /**
+     *  @brief Returns true if the container is full.
+    */
+    inline bool IsFull() const {
+        return samples_.IsFull();
+    }
+
+    const value_type& operator[](std::size_t n) const {
+        return samples_[n];
+    }
+};
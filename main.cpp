@@ -2,6 +2,7 @@
 #include <cassert>
 #include <vector>
 #include "Tests.h"
+#include "Sort.h"
 
 #define START_TEST(a) try{            \
 a();                                                                     \
@@ -58,7 +59,13 @@ void TestIsEvenMyImp() {
 // Что можно улучшить. Можно удалить специализацию с алокацией на стеке, так в отсутствии необходимости знать размер
 // стека на этапе компиляции можно удалить шаблонный параметр размера буфера. Нужно переписать алокатор на алокатор со
 // стандартным интерфейсом. Доработать класс, до возможности использования стандартного алокатора.
+// Сделано: аллокатор StandardAllocator поверх стандартного аллокатора (std::allocator_traits), в том числе
+// std::pmr::polymorphic_allocator, выбирается передачей аллокатора третьим параметром шаблона, см. namespace pmr.
 // Добавить возможность увеличения/уменьшения размера буфера, путем релокации памяти.
+// Сделано: класс CircularBuffer, емкость задается во время выполнения, память выделяется стандартным аллокатором,
+// емкость меняется через Reserve/Resize/ShrinkToFit, элементы перемещаются в непрерывный блок за один проход.
+// Замеры скорости: цель CppBenchmarks, кроме времени на операцию выводит аппаратные счетчики на операцию (промахи кэша,
+// ошибки предсказания переходов, IPC), если perf_event_open доступен.
 
 
 //Вопрос 3.
@@ -70,45 +77,13 @@ void TestIsEvenMyImp() {
 //Объяснить почему вы считаете, что функция соответствует заданным критериям.
 
 // Данный способ сортировки, называется сортировкой подсчетом. Это самый быстрый способ сортировки чисел, так как
-// выполняется за O(n+k). А именно, сортировка выполняется в два прохода: первый проход по массиву считывает числа и
-// записывает их колличество в вектор, где индекс это число, а значение это колличество. Второй проход выписывает из
-// этого вектора числа в исходный массив по порядку с учетом их колличества.
+// выполняется за O(n+k), где k - диапазон значений. Сортировка выполняется в три прохода: первый проход находит
+// минимум и максимум (simd::MinMax, векторными инструкциями), второй считает количество каждого числа в векторе
+// размером (максимум - минимум + 1), где индекс это число минус минимум, а значение это количество (BuildHistogram,
+// соседние числа считаются в разные под-гистограммы, чтобы серии одинаковых чисел не ждали друг друга). Третий
+// проход выписывает из этого вектора числа в исходный массив по порядку с учетом их количества.
 
-void CountingSort(std::vector<int>& nums) {
-    int lo = INT_MAX, hi = INT_MIN;
-    std::vector<int> catalog_plus(nums.size(), 0);
-    std::vector<int> catalog_minus(nums.size(), 0);
-
-    for (auto n : nums) {
-        if (n < 0) {
-            if (catalog_minus.size() <= std::abs(n)) {
-                catalog_minus.resize(std::abs(n)*2, 0);
-            }
-            ++catalog_minus[std::abs(n)];
-        } else {
-            if (catalog_plus.size() <= n) {
-                catalog_plus.resize(n * 2, 0);
-            }
-            ++catalog_plus[n];
-        }
-        lo = std::min(lo, n);
-        hi = std::max(hi, n);
-    }
-
-    int j = 0;
-
-    for (int i = lo; i <= hi; ++i) {
-        if (i < 0) {
-            for (int k = 0; k < catalog_minus[std::abs(i)]; ++k) {
-                nums[j++] = i;
-            }
-        } else {
-            for (int k = 0; k < catalog_plus[i]; ++k) {
-                nums[j++] = i;
-            }
-        }
-    }
-}
+// Задание 3 находится в файле Sort.h
 
 void TestCountingSort() {
     std::vector<int> nums = {4, 2, 5, -4, -6, 7, 1, 2, 8, 9, -1, 8, 3, 2, 1};
@@ -142,9 +117,79 @@ int main() {
     START_TEST(CircBufferIteratorOperatorIncrement)
     START_TEST(CircBufferIteratorOperatorEquality)
     START_TEST(CircBufferIteration)
-    START_TEST(CircBufferTimeTest)
+    START_TEST(CircBufferIterationWrapped)
+    START_TEST(CircBufferPowerOfTwoCapacity)
+
+    START_TEST(SpscBufferTryPushTryPop)
+    START_TEST(SpscBufferTwoThreads)
+    START_TEST(SpscBufferTimeTest)
+
+    START_TEST(MpmcBufferTryPushTryPop)
+    START_TEST(MpmcBufferThrowingElement)
+    START_TEST(MpmcBufferManyThreads)
+    START_TEST(MpmcBufferTimeTest)
+
+    START_TEST(RuntimeCircBufferConstruct)
+    START_TEST(RuntimeCircBufferMethods)
+    START_TEST(RuntimeCircBufferReserve)
+    START_TEST(RuntimeCircBufferResize)
+    START_TEST(RuntimeCircBufferShrinkToFit)
+
+    START_TEST(CircBufferStandardAllocator)
+    START_TEST(RuntimeCircBufferStandardAllocator)
+    START_TEST(CircBufferAllocatorTimeTest)
+
+    START_TEST(CircBufferMethodPushBackRange)
+    START_TEST(CircBufferMethodPopFrontInto)
+    START_TEST(CircBufferBulkTimeTest)
+
+    START_TEST(CircBufferMethodArrayOneArrayTwo)
+    START_TEST(CircBufferMethodLinearize)
+
+    START_TEST(CircBufferIteratorRandomAccess)
+    START_TEST(CircBufferIteratorAlgorithms)
+    START_TEST(CircBufferAlgorithmTimeTest)
+
+    START_TEST(CircBufferMethodForEach)
+    START_TEST(CircBufferForEachTimeTest)
+
+    START_TEST(BlockingBufferPushPop)
+    START_TEST(BlockingBufferTwoThreads)
+    START_TEST(BlockingBufferTimeTest)
+
+    START_TEST(CircBufferOverflowPolicy)
+    START_TEST(RuntimeCircBufferOverflowPolicy)
+    START_TEST(CircBufferOverflowPolicyTimeTest)
+
+    START_TEST(MappedCircBufferRecover)
+    START_TEST(MappedCircBufferTimeTest)
+
+    START_TEST(SharedSpscBufferTwoProcesses)
+    START_TEST(SharedSpscBufferTimeTest)
+
+    START_TEST(CircBufferAlignment)
+    START_TEST(ConcurrentBufferPaddedSlots)
+    START_TEST(CircBufferAlignmentTimeTest)
+
+    START_TEST(CircBufferMoveOnly)
+    START_TEST(CircBufferExceptionSafety)
+
+    START_TEST(SlidingWindowStatsMethods)
+    START_TEST(SlidingWindowAggregatorMethods)
+    START_TEST(SlidingWindowTimeTest)
+
+    START_TEST(SimdReductions)
+    START_TEST(SimdReductionsTimeTest)
+
+    START_TEST(TimeWindowBufferMethods)
+    START_TEST(TimeWindowTimeTest)
 
     START_TEST(TestCountingSort)
+    START_TEST(HybridSortDistributions)
+    START_TEST(RadixSortTypes)
+    START_TEST(ParallelSortThreads)
+    START_TEST(SortByKeyStable)
+    START_TEST(SortHistogramKernels)
 
     return 0;
 }